@@ -1,145 +1,370 @@
 #include "app/ImagePreviewWidget.h"
+#include <QApplication>
 #include <QPainter>
 #include <QPaintEvent>
 #include <QFontMetrics>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 
 namespace img2spec {
 
+namespace {
+
+constexpr int kMinLevelSize = 16;    // stop halving below this width / height
+constexpr double kZoomPerNotch = 1.25;
+constexpr double kMaxOversampling = 4.0; // zoom until 4 screen pixels per image column
+constexpr int kPlayheadWidth = 3;
+
+// 2x2 box filter for Grayscale8 (odd trailing rows / columns are folded in)
+QImage halve(const QImage& src) {
+    const int width = std::max(1, src.width() / 2);
+    const int height = std::max(1, src.height() / 2);
+    QImage dst(width, height, QImage::Format_Grayscale8);
+
+    for (int y = 0; y < height; ++y) {
+        const uchar* row0 = src.constScanLine(std::min(2 * y, src.height() - 1));
+        const uchar* row1 = src.constScanLine(std::min(2 * y + 1, src.height() - 1));
+        uchar* out = dst.scanLine(y);
+        for (int x = 0; x < width; ++x) {
+            const int x0 = std::min(2 * x, src.width() - 1);
+            const int x1 = std::min(2 * x + 1, src.width() - 1);
+            out[x] = static_cast<uchar>((row0[x0] + row0[x1] + row1[x0] + row1[x1] + 2) >> 2);
+        }
+    }
+    return dst;
+}
+
+} // namespace
+
 ImagePreviewWidget::ImagePreviewWidget(QWidget* parent)
     : QWidget(parent)
 {
     setMinimumSize(400, 300);
     setStyleSheet("background-color: #2b2b2b;");
+    // Everything is painted from the cached layers; skip the background erase
+    setAttribute(Qt::WA_OpaquePaintEvent);
 }
 
 ImagePreviewWidget::~ImagePreviewWidget() {}
 
-void ImagePreviewWidget::setPixmap(const QPixmap& pixmap) {
-    originalPixmap_ = pixmap;
-    updateScaledPixmap();
+std::vector<QImage> ImagePreviewWidget::buildPyramid(const QImage& image) {
+    std::vector<QImage> levels;
+    if (image.isNull()) {
+        return levels;
+    }
+
+    levels.push_back(image.format() == QImage::Format_Grayscale8
+                         ? image
+                         : image.convertToFormat(QImage::Format_Grayscale8));
+    while (levels.back().width() >= 2 * kMinLevelSize && levels.back().height() >= 2 * kMinLevelSize) {
+        levels.push_back(halve(levels.back()));
+    }
+    return levels;
+}
+
+void ImagePreviewWidget::setImagePyramid(const std::vector<QImage>& levels, const QSize& sourceSize) {
+    levels_.clear();
+    for (const QImage& level : levels) {
+        levels_.push_back(QPixmap::fromImage(level));
+    }
+    sourceSize_ = sourceSize;
+    zoom_ = 1.0;
+    viewStart_ = 0.0;
+    imageLayerValid_ = false;
+    overlayLayerValid_ = false;
     update();
 }
 
 void ImagePreviewWidget::setFrequencyGuides(const std::vector<FrequencyGuide>& guides) {
     frequencyGuides_ = guides;
+    overlayLayerValid_ = false;
     update();
 }
 
 void ImagePreviewWidget::setPlaybackPosition(double positionSec, double durationSec) {
+    const int oldX = playheadX();
     playbackPositionSec_ = positionSec;
     playbackDurationSec_ = durationSec;
-    update();
+    const int newX = playheadX();
+
+    // Only the strips under the old and new playhead change
+    if (oldX == newX) {
+        return;
+    }
+    if (oldX >= 0) {
+        update(playheadStrip(oldX));
+    }
+    if (newX >= 0) {
+        update(playheadStrip(newX));
+    }
 }
 
 void ImagePreviewWidget::clearImage() {
-    originalPixmap_ = QPixmap();
-    scaledPixmap_ = QPixmap();
+    levels_.clear();
+    sourceSize_ = QSize();
+    imageLayer_ = QPixmap();
+    overlayLayer_ = QPixmap();
+    imageLayerValid_ = false;
+    overlayLayerValid_ = false;
+    zoom_ = 1.0;
+    viewStart_ = 0.0;
     frequencyGuides_.clear();
     playbackPositionSec_ = 0.0;
     playbackDurationSec_ = 0.0;
     update();
 }
 
-void ImagePreviewWidget::updateScaledPixmap() {
-    if (originalPixmap_.isNull()) {
-        scaledPixmap_ = QPixmap();
+QRect ImagePreviewWidget::imageRect() const {
+    if (levels_.empty() || sourceSize_.isEmpty()) {
+        return QRect();
+    }
+
+    // Fit the full image while maintaining aspect ratio, centered
+    const QSize fitted = sourceSize_.scaled(size(), Qt::KeepAspectRatio);
+    return QRect((width() - fitted.width()) / 2, (height() - fitted.height()) / 2,
+                 fitted.width(), fitted.height());
+}
+
+int ImagePreviewWidget::playheadX() const {
+    if (playbackDurationSec_ <= 0 || levels_.empty()) {
+        return -1;
+    }
+    const QRect target = imageRect();
+    const double t = std::min(1.0, std::max(0.0, playbackPositionSec_ / playbackDurationSec_));
+    const double u = (t - viewStart_) * zoom_;
+    if (u < 0.0 || u > 1.0) {
+        return -1; // scrolled out of view
+    }
+    return target.left() + static_cast<int>(u * target.width());
+}
+
+QRect ImagePreviewWidget::playheadStrip(int x) const {
+    const QRect target = imageRect();
+    return QRect(x - kPlayheadWidth, target.top(), 2 * kPlayheadWidth + 1, target.height());
+}
+
+double ImagePreviewWidget::maxZoom() const {
+    const QRect target = imageRect();
+    if (levels_.empty() || target.width() <= 0) {
+        return 1.0;
+    }
+    const double columnsPerPixel = levels_.front().width() / (target.width() * devicePixelRatioF());
+    return std::max(1.0, columnsPerPixel * kMaxOversampling);
+}
+
+void ImagePreviewWidget::setView(double zoom, double viewStart) {
+    zoom = std::min(maxZoom(), std::max(1.0, zoom));
+    viewStart = std::min(1.0 - 1.0 / zoom, std::max(0.0, viewStart));
+    if (zoom == zoom_ && viewStart == viewStart_) {
         return;
     }
+    zoom_ = zoom;
+    viewStart_ = viewStart;
+    imageLayerValid_ = false;
+    update();
+}
+
+void ImagePreviewWidget::rebuildImageLayer(const QRect& target) {
+    const qreal dpr = devicePixelRatioF();
+    const int deviceWidth = std::max(1, static_cast<int>(std::ceil(target.width() * dpr)));
+    const int deviceHeight = std::max(1, static_cast<int>(std::ceil(target.height() * dpr)));
+
+    // Smallest level that still has at least one column / row per device pixel
+    size_t level = 0;
+    while (level + 1 < levels_.size()
+           && levels_[level + 1].width() / zoom_ >= deviceWidth
+           && levels_[level + 1].height() >= deviceHeight) {
+        ++level;
+    }
+    const QPixmap& source = levels_[level];
+    const QRectF sourceRect(viewStart_ * source.width(), 0.0,
+                            source.width() / zoom_, source.height());
 
-    // Scale pixmap to fit widget while maintaining aspect ratio
-    scaledPixmap_ = originalPixmap_.scaled(
-        size(),
-        Qt::KeepAspectRatio,
-        Qt::SmoothTransformation
-    );
+    imageLayer_ = QPixmap(deviceWidth, deviceHeight);
+    imageLayer_.setDevicePixelRatio(dpr);
+    QPainter painter(&imageLayer_);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawPixmap(QRectF(0, 0, target.width(), target.height()), source, sourceRect);
+    imageLayerValid_ = true;
+}
+
+void ImagePreviewWidget::rebuildOverlayLayer(const QRect& target) {
+    const qreal dpr = devicePixelRatioF();
+    overlayLayer_ = QPixmap(size() * dpr);
+    overlayLayer_.setDevicePixelRatio(dpr);
+    overlayLayer_.fill(Qt::transparent);
+    overlayLayerValid_ = true;
+
+    if (frequencyGuides_.empty()) {
+        return;
+    }
+
+    QPainter painter(&overlayLayer_);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    const int imageTop = target.top();
+    const int imageHeight = target.height();
+    const int imageLeft = target.left();
+    const int imageRight = target.right() + 1;
+
+    painter.setPen(QPen(QColor(255, 200, 0, 200), 2, Qt::DashLine));
+    QFont font = painter.font();
+    font.setPointSize(10);
+    font.setBold(true);
+    painter.setFont(font);
+    const QFontMetrics fm(font);
+
+    for (const auto& guide : frequencyGuides_) {
+        // Calculate Y position (0 = top = high freq, 1 = bottom = low freq)
+        const int lineY = imageTop + static_cast<int>(guide.frequencyHz * imageHeight);
+
+        // Draw horizontal line across the image
+        painter.drawLine(imageLeft, lineY, imageRight, lineY);
+
+        // Draw label with background
+        const QString labelText = guide.label;
+        const int textWidth = fm.horizontalAdvance(labelText);
+        const int textHeight = fm.height();
+        const int padding = 4;
+
+        // Position label on the left side
+        const int labelX = imageLeft + 10;
+        const int labelY = lineY - textHeight / 2;
+
+        // Draw background rectangle
+        painter.fillRect(
+            labelX - padding,
+            labelY - padding,
+            textWidth + 2 * padding,
+            textHeight + 2 * padding,
+            QColor(0, 0, 0, 180)
+        );
+
+        // Draw text
+        painter.setPen(QColor(255, 200, 0));
+        painter.drawText(labelX, labelY + fm.ascent(), labelText);
+
+        // Restore line pen
+        painter.setPen(QPen(QColor(255, 200, 0, 200), 2, Qt::DashLine));
+    }
 }
 
 void ImagePreviewWidget::paintEvent(QPaintEvent* event) {
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
+    const QRect dirty = event->rect();
 
     // Draw background
-    painter.fillRect(rect(), QColor(43, 43, 43));
+    painter.fillRect(dirty, QColor(43, 43, 43));
 
-    if (scaledPixmap_.isNull()) {
+    if (levels_.empty()) {
         // Draw "No image loaded" text
         painter.setPen(QColor(136, 136, 136));
         painter.drawText(rect(), Qt::AlignCenter, "No image loaded\nDrag & drop or click 'Open Image'");
         return;
     }
 
-    // Center the scaled pixmap
-    const int x = (width() - scaledPixmap_.width()) / 2;
-    const int y = (height() - scaledPixmap_.height()) / 2;
-    painter.drawPixmap(x, y, scaledPixmap_);
-
-    // Draw frequency guides
-    if (!frequencyGuides_.empty() && !scaledPixmap_.isNull()) {
-        const int imageTop = y;
-        const int imageBottom = y + scaledPixmap_.height();
-        const int imageHeight = scaledPixmap_.height();
-        const int imageLeft = x;
-        const int imageRight = x + scaledPixmap_.width();
+    const QRect target = imageRect();
+    if (!imageLayerValid_) {
+        rebuildImageLayer(target);
+    }
+    if (!overlayLayerValid_) {
+        rebuildOverlayLayer(target);
+    }
 
-        painter.setPen(QPen(QColor(255, 200, 0, 200), 2, Qt::DashLine));
-        QFont font = painter.font();
-        font.setPointSize(10);
-        font.setBold(true);
-        painter.setFont(font);
-
-        for (const auto& guide : frequencyGuides_) {
-            // Calculate Y position (0 = top = high freq, 1 = bottom = low freq)
-            const int lineY = imageTop + static_cast<int>(guide.frequencyHz * imageHeight);
-
-            // Draw horizontal line across the image
-            painter.drawLine(imageLeft, lineY, imageRight, lineY);
-
-            // Draw label with background
-            const QString labelText = guide.label;
-            QFontMetrics fm(font);
-            const int textWidth = fm.horizontalAdvance(labelText);
-            const int textHeight = fm.height();
-            const int padding = 4;
-
-            // Position label on the left side
-            const int labelX = imageLeft + 10;
-            const int labelY = lineY - textHeight / 2;
-
-            // Draw background rectangle
-            painter.fillRect(
-                labelX - padding,
-                labelY - padding,
-                textWidth + 2 * padding,
-                textHeight + 2 * padding,
-                QColor(0, 0, 0, 180)
-            );
-
-            // Draw text
-            painter.setPen(QColor(255, 200, 0));
-            painter.drawText(labelX, labelY + fm.ascent(), labelText);
-
-            // Restore line pen
-            painter.setPen(QPen(QColor(255, 200, 0, 200), 2, Qt::DashLine));
-        }
+    // Blit only the damaged part of each cached layer
+    const qreal dpr = devicePixelRatioF();
+    auto toDevice = [dpr](const QRect& r) {
+        return QRectF(r.x() * dpr, r.y() * dpr, r.width() * dpr, r.height() * dpr);
+    };
+    const QRect imageDirty = dirty.intersected(target);
+    if (!imageDirty.isEmpty()) {
+        painter.drawPixmap(QRectF(imageDirty), imageLayer_,
+                           toDevice(imageDirty.translated(-target.topLeft())));
     }
+    painter.drawPixmap(QRectF(dirty), overlayLayer_, toDevice(dirty));
 
     // Playback position (playhead)
-    if (playbackDurationSec_ > 0 && !scaledPixmap_.isNull()) {
-        const int imageTop = y;
-        const int imageBottom = y + scaledPixmap_.height();
-        const int imageLeft = x;
-        const int imageWidth = scaledPixmap_.width();
-        const double t = std::min(1.0, std::max(0.0, playbackPositionSec_ / playbackDurationSec_));
-        const int headX = imageLeft + static_cast<int>(t * imageWidth);
-        painter.setPen(QPen(QColor(0, 200, 255), 3, Qt::SolidLine));
-        painter.drawLine(headX, imageTop, headX, imageBottom);
+    const int headX = playheadX();
+    if (headX >= 0 && dirty.intersects(playheadStrip(headX))) {
+        painter.setPen(QPen(QColor(0, 200, 255), kPlayheadWidth, Qt::SolidLine));
+        painter.drawLine(headX, target.top(), headX, target.bottom());
     }
 }
 
 void ImagePreviewWidget::resizeEvent(QResizeEvent* event) {
     QWidget::resizeEvent(event);
-    updateScaledPixmap();
+    imageLayerValid_ = false;
+    overlayLayerValid_ = false;
+    setView(zoom_, viewStart_); // maxZoom depends on the fitted width
+}
+
+void ImagePreviewWidget::wheelEvent(QWheelEvent* event) {
+    const QRect target = imageRect();
+    if (target.isEmpty()) {
+        event->ignore();
+        return;
+    }
+
+    // Zoom the time axis around the cursor
+    const double cursor = std::min(1.0, std::max(0.0,
+        (event->position().x() - target.left()) / static_cast<double>(target.width())));
+    const double anchor = viewStart_ + cursor / zoom_;
+    const double zoom = zoom_ * std::pow(kZoomPerNotch, event->angleDelta().y() / 120.0);
+    const double clampedZoom = std::min(maxZoom(), std::max(1.0, zoom));
+    setView(clampedZoom, anchor - cursor / clampedZoom);
+    event->accept();
+}
+
+void ImagePreviewWidget::mousePressEvent(QMouseEvent* event) {
+    if (event->button() == Qt::LeftButton) {
+        pressPos_ = event->position().toPoint();
+        clickPending_ = imageRect().contains(pressPos_);
+    }
+    if (event->button() == Qt::LeftButton && zoom_ > 1.0) {
+        panning_ = true;
+        panLastX_ = static_cast<int>(event->position().x());
+        setCursor(Qt::ClosedHandCursor);
+    }
+    QWidget::mousePressEvent(event);
+}
+
+void ImagePreviewWidget::mouseMoveEvent(QMouseEvent* event) {
+    if (clickPending_
+        && (event->position().toPoint() - pressPos_).manhattanLength() >= QApplication::startDragDistance()) {
+        clickPending_ = false;
+    }
+    const QRect target = imageRect();
+    if (panning_ && !target.isEmpty()) {
+        const int x = static_cast<int>(event->position().x());
+        setView(zoom_, viewStart_ - (x - panLastX_) / (static_cast<double>(target.width()) * zoom_));
+        panLastX_ = x;
+    }
+    QWidget::mouseMoveEvent(event);
+}
+
+void ImagePreviewWidget::mouseReleaseEvent(QMouseEvent* event) {
+    if (panning_ && event->button() == Qt::LeftButton) {
+        panning_ = false;
+        unsetCursor();
+    }
+    const QRect target = imageRect();
+    if (clickPending_ && event->button() == Qt::LeftButton && !target.isEmpty()) {
+        clickPending_ = false;
+        const double cursor = (event->position().x() - target.left()) / static_cast<double>(target.width());
+        const double fraction = viewStart_ + std::min(1.0, std::max(0.0, cursor)) / zoom_;
+        emit seekRequested(std::min(fraction, std::nextafter(1.0, 0.0)));
+    }
+    QWidget::mouseReleaseEvent(event);
+}
+
+void ImagePreviewWidget::mouseDoubleClickEvent(QMouseEvent* event) {
+    setView(1.0, 0.0);
+    QWidget::mouseDoubleClickEvent(event); // forwards to mousePressEvent()
+    // The first click of the pair already seeked
+    clickPending_ = false;
 }
 
 } // namespace img2spec
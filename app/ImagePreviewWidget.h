@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QWidget>
+#include <QImage>
 #include <QPixmap>
 #include <QLabel>
 #include <vector>
@@ -12,6 +13,18 @@ struct FrequencyGuide {
     QString label;
 };
 
+/**
+ * Spectrogram image view with frequency guides and a playback playhead.
+ *
+ * - The image is held as a mipmap pyramid; each repaint of the image layer
+ *   samples the smallest level that still covers the on-screen pixels
+ * - Horizontal (time) zoom with the mouse wheel, drag to pan, double-click
+ *   to reset; the frequency axis always fits the widget height
+ * - A click (press and release without dragging) requests a seek there
+ * - Image and guides are pre-rendered into cached layers that are only
+ *   rebuilt on resize / zoom / pan / guide changes
+ * - Playhead moves repaint just the strips under the old and new position
+ */
 class ImagePreviewWidget : public QWidget {
     Q_OBJECT
 
@@ -19,20 +32,60 @@ public:
     explicit ImagePreviewWidget(QWidget* parent = nullptr);
     ~ImagePreviewWidget();
 
-    void setPixmap(const QPixmap& pixmap);
+    // Halve repeatedly (2x2 box filter) down to a few pixels; level 0 is image.
+    // Thread-safe, meant to run next to the image conversion off the GUI thread.
+    static std::vector<QImage> buildPyramid(const QImage& image);
+
+    // levels from buildPyramid(); sourceSize is the full image size and sets
+    // the displayed aspect ratio (level 0 may be scaled non-uniformly)
+    void setImagePyramid(const std::vector<QImage>& levels, const QSize& sourceSize);
     void setFrequencyGuides(const std::vector<FrequencyGuide>& guides);
     void setPlaybackPosition(double positionSec, double durationSec);
     void clearImage();
 
+signals:
+    // Left click on the image; fraction of the image width, [0, 1)
+    void seekRequested(double fraction);
+
 protected:
     void paintEvent(QPaintEvent* event) override;
     void resizeEvent(QResizeEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
 
 private:
-    void updateScaledPixmap();
+    QRect imageRect() const;
+    int playheadX() const;
+    QRect playheadStrip(int x) const;
+    double maxZoom() const;
+    void setView(double zoom, double viewStart);
+
+    void rebuildImageLayer(const QRect& target);
+    void rebuildOverlayLayer(const QRect& target);
+
+    std::vector<QPixmap> levels_;
+    QSize sourceSize_;
+
+    // Cached layers (device pixel resolution)
+    QPixmap imageLayer_;   // imageRect() sized, current zoom / pan
+    QPixmap overlayLayer_; // widget sized, transparent, frequency guides
+    bool imageLayerValid_ = false;
+    bool overlayLayerValid_ = false;
+
+    // Visible range: [viewStart_, viewStart_ + 1 / zoom_) of the image width
+    double zoom_ = 1.0;
+    double viewStart_ = 0.0;
+    bool panning_ = false;
+    int panLastX_ = 0;
+
+    // Click detection: press position, and whether the press became a drag
+    // (or the second press of a double-click, which resets the view instead)
+    QPoint pressPos_;
+    bool clickPending_ = false;
 
-    QPixmap originalPixmap_;
-    QPixmap scaledPixmap_;
     std::vector<FrequencyGuide> frequencyGuides_;
     double playbackPositionSec_ = 0.0;
     double playbackDurationSec_ = 0.0;
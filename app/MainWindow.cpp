@@ -3,7 +3,15 @@
 #include "core/Stft.h"
 #include "core/GriffinLim.h"
 #include "core/Leveling.h"
+#include "core/Resampler.h"
 #include "core/WavWriter.h"
+#include "core/ChannelLayout.h"
+#include "core/ImageCache.h"
+#include "core/RenderEstimator.h"
+#include "core/RenderPipeline.h"
+#include "core/RegionRenderer.h"
+#include "core/SeekRenderer.h"
+#include "app/PreviewAudioDevice.h"
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QImage>
@@ -18,8 +26,11 @@
 #include <QAudioDevice>
 #include <QAudioFormat>
 #include <QAudioSink>
-#include <QBuffer>
 #include <QMediaDevices>
+#include <QStandardPaths>
+#include <QDir>
+#include <QScreen>
+#include <QThreadPool>
 #include <iostream>
 #include <algorithm>
 #include <cstdint>
@@ -28,40 +39,73 @@
 
 namespace img2spec {
 
-// Resample magnitude spectrogram along time axis to achieve target number of frames.
-static std::vector<std::vector<float>> resampleSpectrogramTime(
-    const std::vector<std::vector<float>>& spec,
-    int targetNumFrames)
-{
-    const int numFramesIn = static_cast<int>(spec.size());
-    if (numFramesIn == 0 || targetNumFrames <= 0) {
-        return {};
-    }
-    const int numBins = static_cast<int>(spec[0].size());
-    std::vector<std::vector<float>> out(targetNumFrames);
-    for (int t = 0; t < targetNumFrames; ++t) {
-        out[t].resize(numBins);
-        const double srcIdx = (targetNumFrames == 1)
-            ? 0.0
-            : (t * (numFramesIn - 1.0) / (targetNumFrames - 1.0));
-        const int i0 = std::min(static_cast<int>(srcIdx), numFramesIn - 1);
-        const int i1 = std::min(i0 + 1, numFramesIn - 1);
-        const float frac = static_cast<float>(srcIdx - i0);
-        for (int k = 0; k < numBins; ++k) {
-            out[t][k] = spec[i0][k] * (1.0f - frac) + spec[i1][k] * frac;
+// Preview columns kept per screen pixel, i.e. how far the time axis can be
+// zoomed before the preview runs out of detail
+static constexpr int kPreviewZoomDetail = 8;
+
+// Progressive preview: first block size (frames) and how far the render may
+// run ahead of the playhead
+static constexpr int kProgressiveFirstBlockFrames = 16;
+static constexpr double kProgressiveAheadSec = 30.0;
+// Output held back to calibrate the preview's normalization: several
+// 400 ms loudness gating blocks, so Loudness mode gets a finite reading
+static constexpr double kPreviewCalibrationSec = 2.0;
+
+// Share of the progress bar for the draft when a refinement follows
+static constexpr int kDraftPermille = 150;
+
+// Region re-render after an image edit only while the changed columns stay
+// below this share of the width; beyond it a full render is about as fast
+static constexpr int kMaxRegionPermille = 250;
+
+// Memory for preview stretches kept for seeking (about 20 min at 48 kHz)
+static constexpr size_t kSegmentCacheBytes = size_t(256) << 20;
+
+// Preview quality combo entries
+enum PreviewQuality { kPreviewFull = 0, kPreviewDraftRefine = 1, kPreviewDraftOnly = 2 };
+
+// Draft speed combo entries: cost reduction vs quality
+static DraftOptions draftOptionsForSpeed(int index) {
+    DraftOptions options;
+    if (index == 1) {
+        // Fast: also halve the internal rate (top octave dropped in log mode)
+        options.iterationDivisor = 8;
+        options.hopMultiplier = 2;
+        options.rateDivisor = 2;
+    }
+    return options;
+}
+
+static bool isSupportedImagePath(const QString& path) {
+    static const char* const kExtensions[] = {".png", ".jpg", ".jpeg", ".pgm", ".ppm", ".npy", ".f32"};
+    for (const char* ext : kExtensions) {
+        if (path.endsWith(ext, Qt::CaseInsensitive)) {
+            return true;
         }
     }
-    return out;
+    return false;
 }
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
     , imageLoader_(std::make_unique<ImageLoader>())
+    , renderCache_(std::make_shared<RenderCache>())
+    , segmentCache_(std::make_shared<SegmentCache>(kSegmentCacheBytes))
     , previewSink_(nullptr)
-    , previewBuffer_(nullptr)
+    , previewDevice_(nullptr)
     , previewPositionTimer_(nullptr)
     , previewDurationSec_(0.0)
+    , renderPollTimer_(nullptr)
+    , renderProgressDialog_(nullptr)
+    , previewThreadPool_(new QThreadPool(this))
 {
+    // Decoded planes of large images are cached across sessions
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!cacheDir.isEmpty()) {
+        imageLoader_->setCache(std::make_shared<ImageCache>(
+            QDir(cacheDir).filePath("decoded-images").toStdString()));
+    }
+
     setupUI();
     setWindowTitle("img2spec - Image to Spectrogram Audio Generator");
     resize(1000, 800);
@@ -72,6 +116,13 @@ MainWindow::MainWindow(QWidget* parent)
 }
 
 MainWindow::~MainWindow() {
+    // Preview tasks post back to this window
+    previewThreadPool_->waitForDone();
+
+    if (renderJob_) {
+        renderJob_->cancel.store(true, std::memory_order_relaxed);
+        renderJob_->thread.join();
+    }
     stopPreviewPlayback();
 }
 
@@ -98,10 +149,14 @@ void MainWindow::setupUI() {
     // Image preview with frequency guides
     imagePreview_ = new ImagePreviewWidget(this);
     imageLayout->addWidget(imagePreview_, 1);
+    connect(imagePreview_, &ImagePreviewWidget::seekRequested, this, &MainWindow::onSeek);
 
     previewPositionTimer_ = new QTimer(this);
     connect(previewPositionTimer_, &QTimer::timeout, this, &MainWindow::updatePreviewPosition);
 
+    renderPollTimer_ = new QTimer(this);
+    connect(renderPollTimer_, &QTimer::timeout, this, &MainWindow::onRenderPoll);
+
     mainLayout->addWidget(imageGroup, 1);
 
     // === Parameters Section ===
@@ -121,6 +176,16 @@ void MainWindow::setupUI() {
     bitDepthCombo_->addItems({"16 bit (PCM)", "24 bit (PCM)", "32 bit (Float)"});
     bitDepthCombo_->setCurrentIndex(0);
     row1Layout->addWidget(bitDepthCombo_);
+
+    row1Layout->addWidget(new QLabel("Dither:", this));
+    ditherCombo_ = new QComboBox(this);
+    ditherCombo_->addItems({"Off", "TPDF", "TPDF + Noise Shaping"});
+    ditherCombo_->setCurrentIndex(0);
+    ditherCombo_->setToolTip("Dither applied when quantizing to 16/24-bit PCM (ignored for 32-bit float).");
+    row1Layout->addWidget(ditherCombo_);
+    connect(bitDepthCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        ditherCombo_->setEnabled(index != 2);
+    });
     row1Layout->addStretch();
     paramsLayout->addLayout(row1Layout);
 
@@ -212,13 +277,32 @@ void MainWindow::setupUI() {
 
     // Row 6: Normalize Target & Output Gain
     auto* row6Layout = new QHBoxLayout();
-    row6Layout->addWidget(new QLabel("Normalize Target (dBFS):", this));
+    row6Layout->addWidget(new QLabel("Normalize:", this));
+    normalizeModeCombo_ = new QComboBox(this);
+    normalizeModeCombo_->addItems({"Peak", "Loudness (LUFS)"});
+    normalizeModeCombo_->setToolTip("Peak: normalize the highest sample (or true peak). Loudness: normalize integrated EBU R128 loudness.");
+    row6Layout->addWidget(normalizeModeCombo_);
+
+    normalizeTargetLabel_ = new QLabel("Target (dBFS):", this);
+    row6Layout->addWidget(normalizeTargetLabel_);
     normalizeTargetSpin_ = new QDoubleSpinBox(this);
     normalizeTargetSpin_->setRange(-6.0, 0.0);
     normalizeTargetSpin_->setValue(-1.0);
     normalizeTargetSpin_->setSingleStep(0.5);
     row6Layout->addWidget(normalizeTargetSpin_);
 
+    connect(normalizeModeCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        if (index == 1) {
+            normalizeTargetLabel_->setText("Target (LUFS):");
+            normalizeTargetSpin_->setRange(-36.0, -6.0);
+            normalizeTargetSpin_->setValue(-23.0);
+        } else {
+            normalizeTargetLabel_->setText("Target (dBFS):");
+            normalizeTargetSpin_->setRange(-6.0, 0.0);
+            normalizeTargetSpin_->setValue(-1.0);
+        }
+    });
+
     row6Layout->addWidget(new QLabel("Output Gain (dB):", this));
     outputGainSpin_ = new QDoubleSpinBox(this);
     outputGainSpin_->setRange(-24.0, 12.0);
@@ -234,9 +318,28 @@ void MainWindow::setupUI() {
     limiterCheck_->setChecked(true);
     row7Layout->addWidget(limiterCheck_);
 
+    truePeakCheck_ = new QCheckBox("True Peak (dBTP)", this);
+    truePeakCheck_->setChecked(false);
+    truePeakCheck_->setToolTip("Normalize on the 4x oversampled true peak; with the safety limiter on, use a look-ahead brickwall limiter instead of soft clipping.");
+    row7Layout->addWidget(truePeakCheck_);
+
     stereoCheck_ = new QCheckBox("Stereo (L/R duplicate)", this);
     stereoCheck_->setChecked(false);
     row7Layout->addWidget(stereoCheck_);
+
+    streamingCheck_ = new QCheckBox("Streaming render (bounded memory)", this);
+    streamingCheck_->setChecked(false);
+    streamingCheck_->setToolTip("Export block by block so memory use does not grow with the output duration. Recommended for very long renders.");
+    row7Layout->addWidget(streamingCheck_);
+
+    row7Layout->addWidget(new QLabel("Memory budget:", this));
+    memoryBudgetSpin_ = new QSpinBox(this);
+    memoryBudgetSpin_->setRange(128, 262144);
+    memoryBudgetSpin_->setValue(4096);
+    memoryBudgetSpin_->setSingleStep(512);
+    memoryBudgetSpin_->setSuffix(" MB");
+    memoryBudgetSpin_->setToolTip("Exports and previews predicted to need more working memory than this switch to streaming automatically (previews then play the draft without refinement).");
+    row7Layout->addWidget(memoryBudgetSpin_);
     row7Layout->addStretch();
     paramsLayout->addLayout(row7Layout);
 
@@ -264,6 +367,18 @@ void MainWindow::setupUI() {
     connect(targetDurationSpin_, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
             this, &MainWindow::updateDurationEstimate);
 
+    // Parameters that only affect the memory / CPU estimate
+    connect(freqScaleCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::updateDurationEstimate);
+    connect(maxFreqSpin_, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            this, &MainWindow::updateDurationEstimate);
+    connect(iterationsSpin_, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::updateDurationEstimate);
+    connect(stereoCheck_, &QCheckBox::toggled, this, &MainWindow::updateDurationEstimate);
+    connect(streamingCheck_, &QCheckBox::toggled, this, &MainWindow::updateDurationEstimate);
+    connect(memoryBudgetSpin_, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::updateDurationEstimate);
+
     mainLayout->addWidget(paramsGroup);
 
     // === Duration Display ===
@@ -289,6 +404,32 @@ void MainWindow::setupUI() {
     connect(previewButton_, &QPushButton::clicked, this, &MainWindow::onPreview);
     renderLayout->addWidget(previewButton_);
 
+    progressivePreviewCheck_ = new QCheckBox("Play while rendering", this);
+    progressivePreviewCheck_->setChecked(true);
+    progressivePreviewCheck_->setToolTip("Start preview playback after the first block is reconstructed instead of waiting for the whole render. Loudness is calibrated on the first block; export is unaffected.");
+    renderLayout->addWidget(progressivePreviewCheck_);
+
+    previewQualityCombo_ = new QComboBox(this);
+    previewQualityCombo_->addItems({"Full quality", "Draft, then refine", "Draft only"});
+    previewQualityCombo_->setCurrentIndex(kPreviewDraftRefine);
+    previewQualityCombo_->setToolTip("Draft previews play a cheap render (fewer iterations, coarser hop) right away; \"then refine\" renders full quality in the background and switches playback to it in place.");
+    renderLayout->addWidget(previewQualityCombo_);
+
+    draftSpeedCombo_ = new QComboBox(this);
+    draftSpeedCombo_->addItems({"Balanced draft", "Fast draft"});
+    draftSpeedCombo_->setToolTip("Balanced: 1/4 iterations, 2x hop. Fast: 1/8 iterations, 2x hop, half internal rate (log scale).");
+    renderLayout->addWidget(draftSpeedCombo_);
+
+    // Drafts always play while rendering
+    auto updatePreviewQualityControls = [this]() {
+        const bool draft = previewQualityCombo_->currentIndex() != kPreviewFull;
+        progressivePreviewCheck_->setEnabled(!draft);
+        draftSpeedCombo_->setEnabled(draft);
+    };
+    connect(previewQualityCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, updatePreviewQualityControls);
+    updatePreviewQualityControls();
+
     cancelButton_ = new QPushButton("Cancel", this);
     cancelButton_->setEnabled(false);
     connect(cancelButton_, &QPushButton::clicked, this, &MainWindow::onCancel);
@@ -305,8 +446,19 @@ void MainWindow::setupUI() {
 }
 
 void MainWindow::loadImageFile(const QString& path) {
+    if (renderJob_) {
+        std::cout << "Render in progress, ignoring image: " << path.toStdString() << std::endl;
+        return;
+    }
+
     std::cout << "Loading image: " << path.toStdString() << std::endl;
     stopPreviewPlayback();
+    // Reloading the same file keeps the cache: after an edit the next render
+    // only re-renders the changed columns. Another file makes it dead weight.
+    if (path != currentImagePath_) {
+        renderCache_->clear();
+        segmentCache_->clear();
+    }
 
     if (!imageLoader_->load(path.toStdString())) {
         QMessageBox::critical(this, "Error", "Failed to load image.\nPath: " + path);
@@ -331,7 +483,7 @@ void MainWindow::onOpenImage() {
         this,
         "Open Image",
         "",
-        "Image Files (*.png *.jpg *.jpeg);;All Files (*)",
+        "Image Files (*.png *.jpg *.jpeg *.pgm *.ppm);;Raw Matrices (*.npy *.f32);;All Files (*)",
         nullptr,
         QFileDialog::DontUseNativeDialog  // Force Qt dialog for consistency
     );
@@ -345,30 +497,47 @@ void MainWindow::onOpenImage() {
 }
 
 void MainWindow::updatePreview() {
+    const int generation = ++previewGeneration_;
+
     if (!imageLoader_->isLoaded()) {
         imagePreview_->clearImage();
         return;
     }
 
-    const int width = imageLoader_->getWidth();
-    const int height = imageLoader_->getHeight();
-    const auto& data = imageLoader_->getGrayscaleData();
-
-    // Create QImage from grayscale data
-    QImage image(width, height, QImage::Format_RGB888);
+    const GrayscalePlane plane = imageLoader_->getPlane();
+    const int width = plane.getWidth();
+    const int height = plane.getHeight();
 
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            const float value = data[y * width + x];
-            const int gray = static_cast<int>(value * 255.0f);
-            image.setPixel(x, y, qRgb(gray, gray, gray));
-        }
+    // Rows: nothing finer than the screen can be shown. Columns: keep extra
+    // detail for zooming into the time axis (the widget keeps the aspect ratio)
+    QSize displaySize(1920, 1080);
+    if (const QScreen* screen = imagePreview_->screen()) {
+        displaySize = screen->size() * screen->devicePixelRatio();
     }
-
-    QPixmap pixmap = QPixmap::fromImage(image);
-    imagePreview_->setPixmap(pixmap);
-
-    std::cout << "Preview updated: " << width << "x" << height << std::endl;
+    const int previewWidth = std::max(1, std::min(width, displaySize.width() * kPreviewZoomDetail));
+    const int previewHeight = std::max(1, std::min(height, displaySize.height()));
+
+    // Area-average into a Grayscale8 image and build its mipmaps off the GUI
+    // thread; pixmaps are created back on the GUI thread, and results of
+    // superseded loads are dropped
+    previewThreadPool_->start([this, plane, previewWidth, previewHeight, generation]() {
+        QImage image(previewWidth, previewHeight, QImage::Format_Grayscale8);
+        plane.downsampleToGray8(previewWidth, previewHeight, image.bits(),
+                                static_cast<size_t>(image.bytesPerLine()));
+        const std::vector<QImage> levels = ImagePreviewWidget::buildPyramid(image);
+        const QSize sourceSize(plane.getWidth(), plane.getHeight());
+
+        QMetaObject::invokeMethod(this, [this, levels, sourceSize, generation]() {
+            if (generation != previewGeneration_) {
+                return;
+            }
+            imagePreview_->setImagePyramid(levels, sourceSize);
+            std::cout << "Preview updated: " << levels.front().width() << "x" << levels.front().height()
+                      << ", " << levels.size() << " mip levels"
+                      << " (from " << sourceSize.width() << "x" << sourceSize.height() << ")"
+                      << std::endl;
+        }, Qt::QueuedConnection);
+    });
 }
 
 void MainWindow::updateFrequencyGuides() {
@@ -432,7 +601,7 @@ void MainWindow::updateDurationEstimate() {
     if (useTargetDurationCheck_ && useTargetDurationCheck_->isChecked()) {
         const double targetSec = targetDurationSpin_->value();
         durationLabel_->setText(QString("Target Duration: %1 s (image will be time-resampled)")
-            .arg(targetSec, 0, 'f', 1));
+            .arg(targetSec, 0, 'f', 1) + renderCostText());
         return;
     }
 
@@ -460,165 +629,316 @@ void MainWindow::updateDurationEstimate() {
         .arg(durationText)
         .arg(imageWidth)
         .arg(hopSize)
-        .arg(sampleRate));
+        .arg(sampleRate) + renderCostText());
 
     std::cout << "Duration estimate: " << durationText.toStdString()
               << " (" << durationSeconds << " seconds)" << std::endl;
 }
 
-bool MainWindow::generateAudio(std::vector<float>& finalAudio,
-                               int& sampleRate,
-                               int& channels,
-                               QString* errorMessage,
-                               QProgressDialog* progressDialog) {
-    if (!imageLoader_->isLoaded()) {
-        if (errorMessage) {
-            *errorMessage = "No image loaded.";
-        }
+QString MainWindow::renderCostText() const {
+    RenderEstimate estimate;
+    try {
+        estimate = RenderEstimator::estimate(collectRenderSettings(),
+                                             imageLoader_->getWidth(), imageLoader_->getHeight());
+    } catch (const std::exception&) {
+        return QString();
+    }
+
+    QString text = QString("\nMemory ~%1 (streaming ~%2), CPU ~%3 s")
+        .arg(QString::fromStdString(RenderEstimator::formatBytes(estimate.inMemoryBytes)))
+        .arg(QString::fromStdString(RenderEstimator::formatBytes(estimate.streamingBytes)))
+        .arg(estimate.cpuSeconds, 0, 'f', 1);
+    if (RenderEstimator::shouldStream(estimate, memoryBudgetBytes())) {
+        text += " - over budget, export and preview will stream";
+    }
+    return text;
+}
+
+size_t MainWindow::memoryBudgetBytes() const {
+    return static_cast<size_t>(memoryBudgetSpin_->value()) * 1024 * 1024;
+}
+
+RenderSettings MainWindow::collectRenderSettings() const {
+    RenderSettings settings;
+    SpectrogramParams& spec = settings.spectrogram;
+    spec.sampleRate = sampleRateCombo_->currentText().toInt();
+    spec.fftSize = fftSizeCombo_->currentText().toInt();
+
+    // Parse hop size
+    spec.hopSize = spec.fftSize / 4; // Default
+    const QString hopText = hopSizeCombo_->currentText();
+    if (hopText.contains("/2")) spec.hopSize = spec.fftSize / 2;
+    else if (hopText.contains("/4")) spec.hopSize = spec.fftSize / 4;
+    else if (hopText.contains("/8")) spec.hopSize = spec.fftSize / 8;
+
+    const bool isLinear = (freqScaleCombo_->currentIndex() == 0);
+    spec.freqScale = isLinear ? FrequencyScale::Linear : FrequencyScale::Logarithmic;
+    spec.minFreqHz = minFreqSpin_->value();
+    spec.maxFreqHz = maxFreqSpin_->value();
+    spec.minDb = minDbSpin_->value();
+    spec.gamma = gammaSpin_->value();
+
+    if (!isLinear && spec.minFreqHz >= spec.maxFreqHz) {
+        throw std::runtime_error("Min frequency must be lower than max frequency.");
+    }
+
+    settings.iterations = iterationsSpin_->value();
+    if (useTargetDurationCheck_->isChecked()) {
+        settings.targetDurationSec = targetDurationSpin_->value();
+    }
+    settings.channels = stereoCheck_->isChecked() ? 2 : 1;
+
+    // Parse bit depth
+    const int bitDepthIdx = bitDepthCombo_->currentIndex();
+    if (bitDepthIdx == 0) settings.bitDepth = BitDepth::Int16;
+    else if (bitDepthIdx == 1) settings.bitDepth = BitDepth::Int24;
+    else if (bitDepthIdx == 2) settings.bitDepth = BitDepth::Float32;
+
+    settings.dither.tpdf = (ditherCombo_->currentIndex() >= 1);
+    settings.dither.noiseShaping = (ditherCombo_->currentIndex() == 2);
+
+    PostProcessSettings& post = settings.postProcess;
+    if (normalizeModeCombo_->currentIndex() == 1) {
+        post.normalizeMode = NormalizeMode::Loudness;
+        post.normalizeTargetLufs = normalizeTargetSpin_->value();
+    } else {
+        post.normalizeTargetDbfs = normalizeTargetSpin_->value();
+    }
+    post.outputChannels = settings.channels;
+    post.outputGainDb = outputGainSpin_->value();
+    post.safetyLimiter = limiterCheck_->isChecked();
+    post.truePeak = truePeakCheck_->isChecked();
+    post.sampleRate = spec.sampleRate;
+
+    return settings;
+}
+
+static bool isSmallEdit(int columnBegin, int columnEnd, int imageWidth) {
+    return static_cast<int64_t>(columnEnd - columnBegin) * 1000
+        <= static_cast<int64_t>(imageWidth) * kMaxRegionPermille;
+}
+
+// After an edit to a few columns of the image the previous render is
+// patched instead of rendered again (see RegionRenderer). Returns false when
+// there is nothing to patch or too much changed; throws when cancelled.
+static bool renderEditedRegion(const RenderSettings& settings,
+                               const GrayscalePlane& image,
+                               RenderCache& cache,
+                               const RenderCache::Keys& keys,
+                               RenderProgress* progress,
+                               const ProgressCallback& progressCallback,
+                               const std::atomic<bool>* cancelFlag,
+                               std::shared_ptr<const std::vector<float>>& audio) {
+    GrayscalePlane previousImage;
+    RenderStages base;
+    int columnBegin = 0;
+    int columnEnd = 0;
+    if (!cache.findPreviousRender(settings, &previousImage, &base)
+        || !RegionRenderer::findChangedColumns(previousImage, image, &columnBegin, &columnEnd)) {
+        return false;
+    }
+    if (!isSmallEdit(columnBegin, columnEnd, image.getWidth())) {
+        std::cout << "  Columns " << columnBegin << "-" << columnEnd
+                  << " changed, too many for a region re-render" << std::endl;
         return false;
     }
 
-    auto updateProgress = [&](int value, const QString& text) {
-        if (!progressDialog) {
-            return;
+    std::cout << "  Image changed in columns " << columnBegin << "-" << columnEnd
+              << ", re-rendering that region" << std::endl;
+    if (progress) {
+        progress->setStage(RenderStage::GriffinLim, 150);
+    }
+    RegionRenderer regionRenderer(settings);
+    RenderStages stages;
+    if (!regionRenderer.render(image, columnBegin, columnEnd, base, stages, progressCallback, cancelFlag)) {
+        // Logged by the renderer; a full render follows unless cancelled
+        if (cancelFlag && cancelFlag->load(std::memory_order_relaxed)) {
+            throw std::runtime_error("Cancelled");
         }
-        progressDialog->setValue(value);
-        if (!text.isEmpty()) {
-            progressDialog->setLabelText(text);
+        return false;
+    }
+
+    cache.storeMagnitude(keys.magnitude, stages.magnitude);
+    cache.storeReconstruction(keys.reconstruction, stages.reconstruction);
+    cache.storeAudio(keys.audio, stages.audio);
+    audio = std::move(stages.audio);
+    return true;
+}
+
+bool MainWindow::generateAudio(const RenderSettings& settings,
+                               const GrayscalePlane& image,
+                               RenderCache* cache,
+                               std::shared_ptr<const std::vector<float>>& finalAudio,
+                               RenderProgress* progress,
+                               const std::atomic<bool>* cancelFlag,
+                               std::string* errorMessage) {
+    auto setStage = [progress](RenderStage stage, int permille) {
+        if (progress) {
+            progress->setStage(stage, permille);
         }
-        QApplication::processEvents();
     };
+    auto cancelled = [cancelFlag]() { return cancelFlag && cancelFlag->load(std::memory_order_relaxed); };
 
     try {
-        // Get parameters from UI
-        sampleRate = sampleRateCombo_->currentText().toInt();
-        const int fftSize = fftSizeCombo_->currentText().toInt();
-
-        // Parse hop size
-        int hopSize = fftSize / 4; // Default
-        QString hopText = hopSizeCombo_->currentText();
-        if (hopText.contains("/2")) hopSize = fftSize / 2;
-        else if (hopText.contains("/4")) hopSize = fftSize / 4;
-        else if (hopText.contains("/8")) hopSize = fftSize / 8;
-
-        const bool isLinear = (freqScaleCombo_->currentIndex() == 0);
-        const double minDb = minDbSpin_->value();
-        const double gamma = gammaSpin_->value();
-        const int iterations = iterationsSpin_->value();
-        const double normalizeTarget = normalizeTargetSpin_->value();
-        const double outputGain = outputGainSpin_->value();
-        const bool useLimiter = limiterCheck_->isChecked();
-        const bool stereo = stereoCheck_->isChecked();
-        const double minFreq = minFreqSpin_->value();
-        const double maxFreq = maxFreqSpin_->value();
-
-        if (!isLinear && minFreq >= maxFreq) {
-            throw std::runtime_error("Min frequency must be lower than max frequency.");
+        if (image.isEmpty()) {
+            throw std::runtime_error("No image loaded.");
         }
 
+        const RenderPlan plan = planRender(settings, image.getWidth());
+        const SpectrogramParams& specParams = plan.params;
+        const PostProcessSettings& postSettings = settings.postProcess;
+        const bool loudnessMode = (postSettings.normalizeMode == NormalizeMode::Loudness);
+        const double normalizeTarget = loudnessMode
+            ? postSettings.normalizeTargetLufs
+            : postSettings.normalizeTargetDbfs;
+
+        const int sampleRate = plan.outputRate;
+        const int renderRate = specParams.sampleRate;
+        const int renderFftSize = specParams.fftSize;
+        const int renderHopSize = specParams.hopSize;
+
         std::cout << "Parameters:" << std::endl;
         std::cout << "  Sample Rate: " << sampleRate << " Hz" << std::endl;
-        std::cout << "  FFT Size: " << fftSize << std::endl;
-        std::cout << "  Hop Size: " << hopSize << std::endl;
-        std::cout << "  Frequency Scale: " << (isLinear ? "Linear" : "Logarithmic") << std::endl;
-        std::cout << "  Min dB: " << minDb << std::endl;
-        std::cout << "  Gamma: " << gamma << std::endl;
-        std::cout << "  Griffin-Lim Iterations: " << iterations << std::endl;
-        std::cout << "  Normalize Target: " << normalizeTarget << " dBFS" << std::endl;
-        std::cout << "  Output Gain: " << outputGain << " dB" << std::endl;
-        std::cout << "  Safety Limiter: " << (useLimiter ? "ON" : "OFF") << std::endl;
-        std::cout << "  Stereo: " << (stereo ? "YES" : "NO") << std::endl;
-
-        updateProgress(5, "Building spectrogram from image...");
-
-        // Step 1: Build magnitude spectrogram from image
-        SpectrogramBuilder specBuilder;
-        SpectrogramParams specParams;
-        specParams.fftSize = fftSize;
-        specParams.hopSize = hopSize;
-        specParams.sampleRate = sampleRate;
-        specParams.freqScale = isLinear ? FrequencyScale::Linear : FrequencyScale::Logarithmic;
-        specParams.minFreqHz = minFreq;
-        specParams.maxFreqHz = maxFreq;
-        specParams.minDb = minDb;
-        specParams.gamma = gamma;
-
-        auto magnitudeSpec = specBuilder.buildMagnitudeSpectrogram(
-            imageLoader_->getGrayscaleData(),
-            imageLoader_->getWidth(),
-            imageLoader_->getHeight(),
-            specParams
-        );
-
-        if (useTargetDurationCheck_->isChecked()) {
-            const double targetSec = targetDurationSpin_->value();
-            const int targetNumFrames = static_cast<int>(std::round(targetSec * sampleRate / hopSize));
-            if (targetNumFrames > 0 && targetNumFrames != static_cast<int>(magnitudeSpec.size())) {
-                updateProgress(12, "Resampling to target duration...");
-                magnitudeSpec = resampleSpectrogramTime(magnitudeSpec, targetNumFrames);
-                std::cout << "  Time-resampled spectrogram to " << targetNumFrames
-                          << " frames (target " << targetSec << " s)" << std::endl;
+        std::cout << "  FFT Size: " << settings.spectrogram.fftSize << std::endl;
+        std::cout << "  Hop Size: " << settings.spectrogram.hopSize << std::endl;
+        std::cout << "  Frequency Scale: " << (specParams.freqScale == FrequencyScale::Linear ? "Linear" : "Logarithmic") << std::endl;
+        std::cout << "  Min dB: " << specParams.minDb << std::endl;
+        std::cout << "  Gamma: " << specParams.gamma << std::endl;
+        std::cout << "  Griffin-Lim Iterations: " << settings.iterations << std::endl;
+        std::cout << "  Normalize Target: " << normalizeTarget << (loudnessMode ? " LUFS" : " dBFS") << std::endl;
+        std::cout << "  Output Gain: " << postSettings.outputGainDb << " dB" << std::endl;
+        std::cout << "  Safety Limiter: " << (postSettings.safetyLimiter ? "ON" : "OFF") << std::endl;
+        std::cout << "  Stereo: " << (settings.channels == 2 ? "YES" : "NO") << std::endl;
+        if (renderRate != sampleRate) {
+            std::cout << "  Render Rate: " << renderRate << " Hz (FFT " << renderFftSize
+                      << ", hop " << renderHopSize << ")" << std::endl;
+        }
+
+        const RenderCache::Keys keys = cache ? cache->makeKeys(image, settings) : RenderCache::Keys();
+        if (cache) {
+            if (auto output = cache->findOutput(keys.output)) {
+                std::cout << "  Reusing cached output (settings unchanged)" << std::endl;
+                finalAudio = std::move(output);
+                setStage(RenderStage::PostProcessing, 900);
+                return true;
             }
         }
 
-        updateProgress(15, "Reconstructing phase with Griffin-Lim algorithm...");
+        auto progressCallback = [progress](int current, int total) {
+            if (progress) {
+                progress->setIteration(current, total);
+                progress->setPermille(150 + current * 700 / total);
+            }
+        };
 
-        // Step 2: Griffin-Lim reconstruction
-        Stft stft(fftSize, hopSize);
-        GriffinLim griffinLim;
+        std::shared_ptr<const std::vector<float>> audio = cache ? cache->findAudio(keys.audio) : nullptr;
+        if (audio) {
+            std::cout << "  Reusing cached reconstruction (post-processing changed)" << std::endl;
+        } else if (cache && renderEditedRegion(settings, image, *cache, keys, progress,
+                                                progressCallback, cancelFlag, audio)) {
+            std::cout << "  Patched the previous render (edited columns only)" << std::endl;
+        } else {
+            // Full render: the previous image's stages are not needed any more
+            if (cache) {
+                cache->dropStale(keys);
+            }
+            std::shared_ptr<const RenderCache::Magnitude> magnitudeSpec =
+                cache ? cache->findMagnitude(keys.magnitude) : nullptr;
+            if (magnitudeSpec) {
+                std::cout << "  Reusing cached magnitude spectrogram" << std::endl;
+            } else {
+                setStage(RenderStage::Spectrogram, 50);
+
+                // Step 1: Build magnitude spectrogram from image, stretched to
+                // the target duration the same way streamed frames are
+                auto built = buildMagnitude(image, plan);
+                if (plan.numFrames != plan.numSourceFrames) {
+                    std::cout << "  Time-resampled spectrogram to " << plan.numFrames
+                              << " frames (target " << settings.targetDurationSec << " s)" << std::endl;
+                }
+                magnitudeSpec = std::make_shared<const RenderCache::Magnitude>(std::move(built));
+                if (cache) {
+                    cache->storeMagnitude(keys.magnitude, magnitudeSpec);
+                }
+            }
 
-        auto progressCallback = [progressDialog](int current, int total) {
-            if (!progressDialog) {
-                return;
+            if (cancelled()) {
+                throw std::runtime_error("Cancelled");
+            }
+            setStage(RenderStage::GriffinLim, 150);
+
+            // Step 2: Griffin-Lim reconstruction
+            Stft stft(renderFftSize, renderHopSize);
+            GriffinLim griffinLim;
+
+            std::vector<float> reconstructed = griffinLim.reconstruct(
+                *magnitudeSpec,
+                stft,
+                settings.iterations,
+                progressCallback,
+                cancelFlag
+            );
+
+            if (cancelled()) {
+                throw std::runtime_error("Cancelled");
+            }
+            if (reconstructed.empty()) {
+                throw std::runtime_error("Griffin-Lim reconstruction failed");
             }
-            const int progress = 15 + (current * 70 / total);
-            progressDialog->setValue(progress);
-            progressDialog->setLabelText(QString("Griffin-Lim iteration %1 / %2...").arg(current).arg(total));
-            QApplication::processEvents();
-        };
 
-        std::vector<float> audio = griffinLim.reconstruct(
-            magnitudeSpec,
-            stft,
-            iterations,
-            progressCallback,
-            nullptr // cancelFlag (TODO: STEP 5)
-        );
+            // The render-rate signal is what a later region re-render patches
+            audio = std::make_shared<const std::vector<float>>(std::move(reconstructed));
+            if (cache) {
+                cache->storeReconstruction(keys.reconstruction, audio);
+            }
 
-        updateProgress(85, "Post-processing audio...");
+            if (renderRate != sampleRate) {
+                setStage(RenderStage::Resampling, 850);
+                Resampler resampler(renderRate, sampleRate);
+                audio = std::make_shared<const std::vector<float>>(resampler.resample(*audio));
+                std::cout << "  Resampled " << renderRate << " Hz -> " << sampleRate << " Hz" << std::endl;
+            }
+            if (cache) {
+                cache->storeAudio(keys.audio, audio);
+            }
+        }
 
-        if (audio.empty()) {
-            throw std::runtime_error("Griffin-Lim reconstruction failed");
+        // The stale output goes before the new one is allocated
+        if (cache) {
+            cache->dropStale(keys);
         }
 
-        // Step 3: Post-processing
+        // Step 3: Post-processing (analysis pass + fused apply pass)
+        setStage(RenderStage::PostProcessing, 880);
         std::cout << "\n=== Post-processing ===" << std::endl;
 
-        Leveling::removeDCOffset(audio);
-        std::cout << "  DC offset removed" << std::endl;
-
-        Leveling::normalize(audio, normalizeTarget);
-        std::cout << "  Normalized to " << normalizeTarget << " dBFS" << std::endl;
-
-        Leveling::applyGain(audio, outputGain);
-        std::cout << "  Applied gain: " << outputGain << " dB" << std::endl;
-
-        if (useLimiter) {
-            Leveling::applySafetyLimiter(audio);
-            std::cout << "  Safety limiter applied" << std::endl;
+        PostProcessor postProcessor(postSettings);
+        postProcessor.analyze(audio->data(), audio->size());
+        postProcessor.finalizeAnalysis();
+        std::cout << "  DC offset: " << postProcessor.getMean()
+                  << ", peak: " << postProcessor.getPeak() << std::endl;
+        if (loudnessMode) {
+            std::cout << "  Integrated loudness: " << postProcessor.getIntegratedLoudness() << " LUFS" << std::endl;
         }
 
-        updateProgress(90, "Preparing audio...");
-
-        // Step 4: Convert to stereo if requested
-        finalAudio = audio;
-        channels = 1;
-        if (stereo) {
-            finalAudio = Leveling::monoToStereo(audio);
-            channels = 2;
-            std::cout << "  Converted to stereo" << std::endl;
+        // Step 4: Apply into a new buffer, the reconstruction stays cached.
+        // Output stays mono; stereo is a channel view interleaved by the
+        // writer / audio sink
+        auto output = std::make_shared<std::vector<float>>(audio->size());
+        postProcessor.apply(audio->data(), audio->size(), output->data(), 1);
+        finalAudio = std::move(output);
+        if (cache) {
+            cache->storeOutput(keys.output, finalAudio);
         }
-
+        std::cout << "  Normalized to " << normalizeTarget
+                  << (loudnessMode ? " LUFS" : (postSettings.truePeak ? " dBTP" : " dBFS"))
+                  << ", gain " << postSettings.outputGainDb << " dB"
+                  << (postSettings.safetyLimiter
+                          ? (postSettings.truePeak ? ", look-ahead limiter applied" : ", safety limiter applied")
+                          : "")
+                  << std::endl;
+
+        setStage(RenderStage::PostProcessing, 900);
         return true;
     } catch (const std::exception& e) {
         if (errorMessage) {
@@ -628,67 +948,408 @@ bool MainWindow::generateAudio(std::vector<float>& finalAudio,
     }
 }
 
-void MainWindow::onPreview() {
-    if (!imageLoader_->isLoaded()) {
-        QMessageBox::warning(this, "Error", "No image loaded.");
-        return;
+void MainWindow::runRenderJob(RenderJob& job) {
+    try {
+        if (job.stream) {
+            // Progressive preview: blocks go to the playback stream as soon as
+            // they are committed. Normalization cannot see the whole signal,
+            // so it is calibrated on the first kPreviewCalibrationSec of output
+            // (held back until then); the limiter catches the rest.
+            // Rendering starts at the seek position; stretches already played
+            // come from the segment cache.
+            const RenderPlan plan = planRender(job.streamSettings, job.image.getWidth());
+            const int startFrame = SeekRenderer::frameAt(plan, job.startFraction);
+            const int streamPermille = job.refine ? kDraftPermille : 1000;
+            job.progress.setStage(RenderStage::GriffinLim, 0);
+            auto progressCallback = [&job, streamPermille](int current, int total) {
+                job.progress.setPermille(static_cast<int>(static_cast<int64_t>(current) * streamPermille / total));
+            };
+
+            PostProcessor postProcessor(job.streamSettings.postProcess);
+            const size_t calibrationSamples = static_cast<size_t>(kPreviewCalibrationSec * plan.outputRate);
+            bool calibrated = false;
+            std::vector<float> prefix;
+            std::vector<float> processed;
+            auto processAndPush = [&](const float* samples, size_t count) {
+                processed.resize(count + postProcessor.getLatency());
+                const size_t written = postProcessor.process(samples, count, processed.data(), 1, false);
+                return job.stream->push(processed.data(), written, &job.cancel);
+            };
+            auto calibrate = [&]() {
+                postProcessor.analyze(prefix.data(), prefix.size());
+                postProcessor.finalizeAnalysis();
+                calibrated = true;
+                const bool ok = processAndPush(prefix.data(), prefix.size());
+                prefix = std::vector<float>();
+                return ok;
+            };
+            auto pushBlock = [&](const float* samples, size_t count) {
+                if (calibrated) {
+                    return processAndPush(samples, count);
+                }
+                prefix.insert(prefix.end(), samples, samples + count);
+                return prefix.size() < calibrationSamples || calibrate();
+            };
+
+            // Segments belong to the image and stream settings; the render
+            // cache memoizes the pixel hash
+            const uint64_t segmentKey = job.cache ? job.cache->makeKeys(job.image, job.streamSettings).audio : 0;
+            SeekRenderer renderer(job.streamSettings, job.cache ? job.segments : nullptr, segmentKey);
+            job.success = renderer.render(job.image, startFrame, pushBlock, progressCallback,
+                                          &job.cancel, &job.errorMessage);
+            if (job.success && !calibrated && !prefix.empty()) {
+                // Shorter than the calibration prefix
+                calibrate();
+            }
+            if (job.success && calibrated) {
+                processed.resize(postProcessor.getLatency());
+                const size_t written = postProcessor.process(nullptr, 0, processed.data(), 1, true);
+                job.stream->push(processed.data(), written, &job.cancel);
+            }
+            // Always, so playback ends after a failed render too
+            job.stream->finish();
+            job.durationSec = plan.outputSamples / static_cast<double>(plan.outputRate);
+
+            // Draft is playing; render the final version behind it. The UI
+            // hands it to the playback device once the job has finished.
+            if (job.success && job.refine && !job.stream->isClosed()) {
+                std::cout << "Draft preview rendered, refining..." << std::endl;
+                job.success = generateAudio(job.settings, job.image, job.cache.get(), job.audio,
+                                            &job.progress, &job.cancel, &job.errorMessage);
+            }
+        } else if (job.streaming) {
+            const RenderPlan plan = planRender(job.settings, job.image.getWidth());
+            job.progress.setStage(RenderStage::GriffinLim, 0);
+            auto progressCallback = [&job](int current, int total) {
+                job.progress.setPermille(current * 1000 / total);
+            };
+
+            StreamingRenderer renderer(job.settings);
+            job.success = renderer.render(job.image, job.outputPath, progressCallback,
+                                          &job.cancel, &job.errorMessage);
+            job.durationSec = plan.outputSamples / static_cast<double>(plan.outputRate);
+        } else {
+            job.success = generateAudio(job.settings, job.image, job.cache.get(), job.audio,
+                                        &job.progress, &job.cancel, &job.errorMessage);
+            const int sampleRate = job.settings.spectrogram.sampleRate;
+            job.durationSec = job.audio ? job.audio->size() / static_cast<double>(sampleRate) : 0.0;
+
+            if (job.success && job.kind == RenderJob::Kind::Export) {
+                // Step 5: Write WAV file
+                job.progress.setStage(RenderStage::Writing, 950);
+                std::cout << "\n=== Writing WAV file ===" << std::endl;
+
+                WavWriter wavWriter;
+                wavWriter.setBackend(WavBackend::MemoryMapped);
+                wavWriter.setAsync(true);
+                wavWriter.setDither(job.settings.dither);
+                job.success = wavWriter.write(
+                    job.outputPath,
+                    AudioView::broadcast(job.audio->data(), job.audio->size(), job.settings.channels),
+                    sampleRate,
+                    job.settings.bitDepth
+                );
+                if (!job.success) {
+                    job.errorMessage = "Failed to write WAV file";
+                }
+                job.audio.reset();
+            }
+        }
+    } catch (const std::exception& e) {
+        // Includes std::bad_alloc from oversized in-memory renders
+        job.success = false;
+        job.errorMessage = e.what();
     }
 
-    if (previewSink_ && previewSink_->state() == QAudio::ActiveState) {
-        stopPreviewPlayback();
+    job.progress.setStage(RenderStage::Done, 1000);
+    job.finished.store(true, std::memory_order_release);
+}
+
+static QString renderStageText(const RenderProgress& progress, bool streaming) {
+    if (streaming) {
+        return "Rendering audio (streaming)...";
+    }
+    switch (progress.getStage()) {
+    case RenderStage::Spectrogram:
+        return "Building spectrogram from image...";
+    case RenderStage::GriffinLim:
+        if (progress.getIteration() > 0) {
+            return QString("Griffin-Lim iteration %1 / %2...")
+                .arg(progress.getIteration())
+                .arg(progress.getTotalIterations());
+        }
+        return "Reconstructing phase with Griffin-Lim algorithm...";
+    case RenderStage::Resampling:
+        return "Resampling to output rate...";
+    case RenderStage::PostProcessing:
+        return "Post-processing audio...";
+    case RenderStage::Writing:
+        return "Writing WAV file...";
+    default:
+        return "Rendering audio from image...";
+    }
+}
+
+void MainWindow::startRenderJob(std::unique_ptr<RenderJob> job) {
+    const bool preview = (job->kind == RenderJob::Kind::Preview);
+
+    setUIEnabled(false);
+
+    if (job->stream) {
+        // Playback runs during the render; progress shows in the bar and
+        // the preview button stops both
+        previewButton_->setEnabled(true);
+        RenderJob* worker = job.get();
+        job->thread = std::thread([worker]() { runRenderJob(*worker); });
+        renderJob_ = std::move(job);
+        renderPollTimer_->start(50);
         return;
     }
 
-    stopPreviewPlayback();
+    renderProgressDialog_ = new QProgressDialog(
+        preview ? "Rendering preview audio..." : "Rendering audio from image...", "Cancel", 0, 100, this);
+    renderProgressDialog_->setWindowTitle(preview ? "Preview" : "Rendering");
+    renderProgressDialog_->setWindowModality(Qt::WindowModal);
+    renderProgressDialog_->setMinimumDuration(0);
+    renderProgressDialog_->setAutoClose(false);
+    renderProgressDialog_->setAutoReset(false);
+    renderProgressDialog_->setValue(0);
+    connect(renderProgressDialog_, &QProgressDialog::canceled, this, &MainWindow::onCancel);
+    renderProgressDialog_->show();
+
+    RenderJob* worker = job.get();
+    job->thread = std::thread([worker]() { runRenderJob(*worker); });
+    renderJob_ = std::move(job);
+
+    // Progress is polled, so the worker never waits on the event loop
+    renderPollTimer_->start(50);
+}
 
-    QProgressDialog progressDialog("Rendering preview audio...", "Cancel", 0, 100, this);
-    progressDialog.setWindowTitle("Preview");
-    progressDialog.setWindowModality(Qt::WindowModal);
-    progressDialog.setMinimumDuration(0);
-    progressDialog.setValue(0);
-    progressDialog.show();
-    QApplication::processEvents();
+void MainWindow::onRenderPoll() {
+    if (!renderJob_) {
+        renderPollTimer_->stop();
+        return;
+    }
 
-    setUIEnabled(false);
+    if (renderJob_->finished.load(std::memory_order_acquire)) {
+        finishRenderJob();
+        return;
+    }
 
-    std::vector<float> finalAudio;
-    int sampleRate = 0;
-    int channels = 0;
-    QString errorMessage;
-    const bool success = generateAudio(finalAudio, sampleRate, channels, &errorMessage, &progressDialog);
+    const RenderProgress& progress = renderJob_->progress;
+    const int percent = std::min(99, progress.getPermille() / 10);
+    progressBar_->setValue(percent);
+    if (renderProgressDialog_ && !renderJob_->cancel.load(std::memory_order_relaxed)) {
+        renderProgressDialog_->setValue(percent);
+        renderProgressDialog_->setLabelText(renderStageText(progress, renderJob_->streaming));
+    }
+}
 
+void MainWindow::finishRenderJob() {
+    std::unique_ptr<RenderJob> job = std::move(renderJob_);
+    job->thread.join();
+    renderPollTimer_->stop();
+
+    if (renderProgressDialog_) {
+        renderProgressDialog_->close();
+        renderProgressDialog_->deleteLater();
+        renderProgressDialog_ = nullptr;
+    }
     setUIEnabled(true);
     progressBar_->setValue(0);
 
-    if (!success) {
-        if (errorMessage.isEmpty()) {
-            errorMessage = "Failed to render preview audio.";
+    // A seek stopped the progressive preview: start over at the new position
+    if (pendingSeekFraction_ >= 0.0) {
+        const double fraction = pendingSeekFraction_;
+        pendingSeekFraction_ = -1.0;
+        startPreview(fraction);
+        return;
+    }
+
+    const bool preview = (job->kind == RenderJob::Kind::Preview);
+
+    if (!job->success) {
+        if (job->cancel.load()) {
+            std::cout << (preview ? "Preview" : "Render") << " cancelled" << std::endl;
+            return;
+        }
+        if (job->stream) {
+            stopPreviewPlayback();
+        }
+        const QString message = job->errorMessage.empty()
+            ? QString(preview ? "Failed to render preview audio." : "Failed to render audio.")
+            : QString::fromStdString(job->errorMessage);
+        std::cerr << (preview ? "Preview" : "Render") << " error: " << message.toStdString() << std::endl;
+        if (preview) {
+            QMessageBox::critical(this, "Preview Error",
+                QString("Failed to render preview audio:\n%1").arg(message));
+        } else {
+            QMessageBox::critical(this, "Render Error",
+                QString("Failed to render audio:\n%1").arg(message));
+        }
+        return;
+    }
+
+    if (job->stream) {
+        std::cout << "Progressive preview render complete ("
+                  << job->durationSec << " s)" << std::endl;
+        if (job->refine && job->audio && previewDevice_) {
+            std::cout << "Switching preview playback to the refined render" << std::endl;
+            previewDevice_->setRefinedAudio(std::move(job->audio));
+        }
+        return;
+    }
+    if (preview) {
+        startPreviewPlayback(std::move(job->audio),
+                             job->settings.spectrogram.sampleRate, job->settings.channels,
+                             job->startFraction);
+        return;
+    }
+
+    std::cout << "\n=== Render Complete ===" << std::endl;
+    QMessageBox::information(this, "Success",
+        QString("Audio rendered successfully!\n\nFile: %1\nDuration: %2 seconds")
+            .arg(QString::fromStdString(job->outputPath))
+            .arg(job->durationSec, 0, 'f', 2));
+}
+
+void MainWindow::onPreview() {
+    if (renderJob_) {
+        // "Stop Preview" while a progressive preview is still rendering
+        if (renderJob_->stream) {
+            pendingSeekFraction_ = -1.0;
+            stopPreviewPlayback();
         }
-        QMessageBox::critical(this, "Preview Error",
-            QString("Failed to render preview audio:\n%1").arg(errorMessage));
         return;
     }
 
-    progressDialog.setValue(95);
-    progressDialog.setLabelText("Starting playback...");
-    QApplication::processEvents();
+    if (!imageLoader_->isLoaded()) {
+        QMessageBox::warning(this, "Error", "No image loaded.");
+        return;
+    }
 
-    startPreviewPlayback(finalAudio, sampleRate, channels);
+    if (previewSink_ && previewSink_->state() == QAudio::ActiveState) {
+        stopPreviewPlayback();
+        return;
+    }
 
-    progressDialog.setValue(100);
-    QApplication::processEvents();
+    stopPreviewPlayback();
+    startPreview(0.0);
 }
 
-void MainWindow::startPreviewPlayback(const std::vector<float>& audio, int sampleRate, int channels) {
-    if (audio.empty()) {
-        QMessageBox::warning(this, "Preview Error", "Generated audio is empty.");
+void MainWindow::onSeek(double fraction) {
+    if (!imageLoader_->isLoaded()) {
+        return;
+    }
+    if (renderJob_) {
+        // A progressive preview restarts once its render has stopped;
+        // exports are not interrupted
+        if (renderJob_->stream) {
+            stopPreviewPlayback();
+            pendingSeekFraction_ = fraction;
+        }
+        return;
+    }
+
+    std::cout << "Seek to " << fraction * 100.0 << "% of the preview" << std::endl;
+    stopPreviewPlayback();
+    startPreview(fraction);
+}
+
+void MainWindow::startPreview(double startFraction) {
+    auto job = std::make_unique<RenderJob>();
+    job->kind = RenderJob::Kind::Preview;
+    try {
+        job->settings = collectRenderSettings();
+    } catch (const std::exception& e) {
+        QMessageBox::critical(this, "Preview Error",
+            QString("Failed to render preview audio:\n%1").arg(e.what()));
         return;
     }
+    job->image = imageLoader_->getPlane();
+    job->cache = renderCache_;
+    job->startFraction = startFraction;
+    job->segments = segmentCache_;
+
+    // Over the memory budget, the preview streams the way an export would:
+    // no whole-signal render, neither as refinement nor as the fallback
+    const RenderEstimate estimate = RenderEstimator::estimate(
+        job->settings, imageLoader_->getWidth(), imageLoader_->getHeight());
+    const bool overBudget = RenderEstimator::shouldStream(estimate, memoryBudgetBytes());
+
+    // Once the full reconstruction is cached (an earlier preview or export),
+    // only post-processing is left: skip the draft and play the real thing.
+    // Same after an edit of the reloaded image, if only a region is re-rendered.
+    bool reconstructionCached = false;
+    if (renderCache_->isCurrentImage(job->image)) {
+        const RenderCache::Keys keys = renderCache_->makeKeys(job->image, job->settings);
+        // Nothing left to render (a replay, or a seek in a finished preview)
+        if (auto output = renderCache_->findOutput(keys.output)) {
+            startPreviewPlayback(std::move(output), job->settings.spectrogram.sampleRate,
+                                 job->settings.channels, startFraction);
+            return;
+        }
+        reconstructionCached = !overBudget && renderCache_->findAudio(keys.audio) != nullptr;
+    } else if (!overBudget) {
+        GrayscalePlane renderedImage;
+        int columnBegin = 0;
+        int columnEnd = 0;
+        reconstructionCached = renderCache_->canPatch(job->image, job->settings, &renderedImage)
+            && RegionRenderer::findChangedColumns(renderedImage, job->image, &columnBegin, &columnEnd)
+            && isSmallEdit(columnBegin, columnEnd, job->image.getWidth());
+    }
 
+    // Seeks always stream, so only the part after the position is rendered
+    const int quality = previewQualityCombo_->currentIndex();
+    const bool seeking = startFraction > 0.0;
+    if (overBudget) {
+        std::cout << "Over the " << memoryBudgetSpin_->value()
+                  << " MB memory budget, preview streams without refinement" << std::endl;
+    }
+    if (!reconstructionCached
+        && (quality != kPreviewFull || progressivePreviewCheck_->isChecked() || seeking || overBudget)) {
+        const int sampleRate = job->settings.spectrogram.sampleRate;
+        job->streamSettings = (quality == kPreviewFull)
+            ? job->settings
+            : makeDraftSettings(job->settings, job->image.getWidth(),
+                                draftOptionsForSpeed(draftSpeedCombo_->currentIndex()));
+        job->streamSettings.firstBlockFrames = kProgressiveFirstBlockFrames;
+        // A refinement renders the whole signal from frame 0 in memory, so a
+        // seek or an over-budget render plays the draft only
+        job->refine = (quality == kPreviewDraftRefine) && !seeking && !overBudget;
+        const RenderPlan plan = planRender(job->streamSettings, job->image.getWidth());
+        const size_t startSample = SeekRenderer::outputSampleAt(plan, SeekRenderer::frameAt(plan, startFraction));
+
+        // A draft that is refined must not wait for the playhead: the whole
+        // draft fits in the queue, so the refinement starts right after it
+        const size_t queueSamples = job->refine
+            ? plan.outputSamples + 1
+            : static_cast<size_t>(kProgressiveAheadSec * sampleRate);
+        job->stream = std::make_shared<PreviewStream>(queueSamples);
+
+        QAudioFormat::SampleFormat sampleFormat;
+        if (!openPreviewSink(sampleRate, job->settings.channels, &sampleFormat)) {
+            return;
+        }
+        previewDevice_ = new PreviewAudioDevice(job->stream, job->settings.channels, sampleFormat, this);
+        previewDevice_->setStartFrame(startSample);
+        previewDevice_->open(QIODevice::ReadOnly);
+
+        startRenderJob(std::move(job));
+        beginPreviewPlayback(previewDevice_, sampleRate,
+                             plan.outputSamples / static_cast<double>(sampleRate),
+                             startSample / static_cast<double>(sampleRate));
+        return;
+    }
+
+    startRenderJob(std::move(job));
+}
+
+bool MainWindow::openPreviewSink(int sampleRate, int channels, QAudioFormat::SampleFormat* sampleFormatOut) {
     QAudioDevice device = QMediaDevices::defaultAudioOutput();
     if (device.isNull()) {
         QMessageBox::warning(this, "Preview Error", "No audio output device is available.");
-        return;
+        return false;
     }
 
     QAudioFormat format;
@@ -705,27 +1366,10 @@ void MainWindow::startPreviewPlayback(const std::vector<float>& audio, int sampl
                 QString("Audio device does not support the current format.\nSample Rate: %1 Hz\nChannels: %2\nTry a different sample rate or disable stereo.")
                     .arg(sampleRate)
                     .arg(channels));
-            return;
+            return false;
         }
     }
 
-    QByteArray audioBytes;
-    if (sampleFormat == QAudioFormat::Float) {
-        audioBytes.resize(static_cast<int>(audio.size() * sizeof(float)));
-        std::memcpy(audioBytes.data(), audio.data(), audioBytes.size());
-    } else {
-        audioBytes.resize(static_cast<int>(audio.size() * sizeof(int16_t)));
-        auto* dst = reinterpret_cast<int16_t*>(audioBytes.data());
-        for (size_t i = 0; i < audio.size(); ++i) {
-            const float clamped = std::max(-1.0f, std::min(1.0f, audio[i]));
-            dst[i] = static_cast<int16_t>(std::lrintf(clamped * 32767.0f));
-        }
-    }
-
-    previewBuffer_ = new QBuffer(this);
-    previewBuffer_->setData(audioBytes);
-    previewBuffer_->open(QIODevice::ReadOnly);
-
     previewSink_ = new QAudioSink(device, format, this);
     connect(previewSink_, &QAudioSink::stateChanged, this, [this](QAudio::State state) {
         if (state == QAudio::IdleState) {
@@ -738,22 +1382,56 @@ void MainWindow::startPreviewPlayback(const std::vector<float>& audio, int sampl
         }
     });
 
-    previewSink_->start(previewBuffer_);
+    *sampleFormatOut = sampleFormat;
+    return true;
+}
+
+void MainWindow::beginPreviewPlayback(QIODevice* source, int sampleRate, double durationSec, double startSec) {
+    previewSink_->start(source);
     previewButton_->setText("Stop Preview");
 
-    previewDurationSec_ = static_cast<double>(audio.size()) / (channels * sampleRate);
+    previewSampleRate_ = sampleRate;
+    previewDurationSec_ = durationSec;
+    previewStartSec_ = startSec;
     auto formatTime = [](double sec) {
         int m = static_cast<int>(sec) / 60;
         double s = sec - m * 60;
         return QString("%1:%2").arg(m).arg(s, 0, 'f', 1);
     };
-    playbackHeaderLabel_->setText(QString("Preview: 0:00.0 / %1").arg(formatTime(previewDurationSec_)));
+    playbackHeaderLabel_->setText(
+        QString("Preview: %1 / %2").arg(formatTime(previewStartSec_)).arg(formatTime(previewDurationSec_)));
+    imagePreview_->setPlaybackPosition(previewStartSec_, previewDurationSec_);
     previewPositionTimer_->start(50);
 }
 
+void MainWindow::startPreviewPlayback(std::shared_ptr<const std::vector<float>> audio,
+                                      int sampleRate, int channels, double startFraction) {
+    if (!audio || audio->empty()) {
+        QMessageBox::warning(this, "Preview Error", "Generated audio is empty.");
+        return;
+    }
+
+    QAudioFormat::SampleFormat sampleFormat;
+    if (!openPreviewSink(sampleRate, channels, &sampleFormat)) {
+        return;
+    }
+
+    // The device converts and interleaves from the shared render as the sink
+    // pulls, so playback starts without a full-size copy
+    const double durationSec = static_cast<double>(audio->size()) / sampleRate;
+    const size_t startFrame = std::min(audio->size() - 1,
+        static_cast<size_t>(std::max(0.0, startFraction) * audio->size()));
+    previewDevice_ = new PreviewAudioDevice(std::move(audio), channels, sampleFormat, this);
+    previewDevice_->setStartFrame(startFrame);
+    previewDevice_->open(QIODevice::ReadOnly);
+
+    beginPreviewPlayback(previewDevice_, sampleRate, durationSec, startFrame / static_cast<double>(sampleRate));
+}
+
 void MainWindow::stopPreviewPlayback() {
     previewPositionTimer_->stop();
     previewDurationSec_ = 0.0;
+    previewStartSec_ = 0.0;
     playbackHeaderLabel_->setText("Preview: — / —");
     if (imagePreview_) {
         imagePreview_->setPlaybackPosition(0.0, 0.0);
@@ -765,10 +1443,16 @@ void MainWindow::stopPreviewPlayback() {
         previewSink_ = nullptr;
     }
 
-    if (previewBuffer_) {
-        previewBuffer_->close();
-        previewBuffer_->deleteLater();
-        previewBuffer_ = nullptr;
+    if (previewDevice_) {
+        previewDevice_->close();
+        previewDevice_->deleteLater();
+        previewDevice_ = nullptr;
+    }
+
+    // Stopping a progressive preview also stops its render
+    if (renderJob_ && renderJob_->stream) {
+        renderJob_->stream->close();
+        renderJob_->cancel.store(true, std::memory_order_relaxed);
     }
 
     if (previewButton_) {
@@ -781,7 +1465,13 @@ void MainWindow::updatePreviewPosition() {
         return;
     }
     const qint64 us = previewSink_->processedUSecs();
-    const double posSec = static_cast<double>(us) / 1e6;
+    double posSec = static_cast<double>(us) / 1e6;
+    if (previewDevice_) {
+        // Silence played while the render caught up is not image time
+        posSec = std::max(0.0, posSec - previewDevice_->getUnderrunFrames()
+                                            / static_cast<double>(previewSampleRate_));
+    }
+    posSec = std::min(previewDurationSec_, previewStartSec_ + posSec);
     auto formatTime = [](double sec) {
         int m = static_cast<int>(sec) / 60;
         double s = sec - m * 60;
@@ -798,6 +1488,10 @@ void MainWindow::onRender() {
     std::cout << "\n=== onRender() called ===" << std::endl;
     std::cout.flush();
 
+    if (renderJob_) {
+        return;
+    }
+
     stopPreviewPlayback();
 
     if (!imageLoader_->isLoaded()) {
@@ -834,82 +1528,49 @@ void MainWindow::onRender() {
     std::cout << "\n=== Starting Render ===" << std::endl;
     std::cout << "Output file: " << savePath.toStdString() << std::endl;
 
-    // Create progress dialog
-    QProgressDialog progressDialog("Rendering audio from image...", "Cancel", 0, 100, this);
-    progressDialog.setWindowTitle("Rendering");
-    progressDialog.setWindowModality(Qt::WindowModal);
-    progressDialog.setMinimumDuration(0);
-    progressDialog.setValue(0);
-    progressDialog.show();
-    QApplication::processEvents();
-
-    // Disable UI during rendering
-    setUIEnabled(false);
+    auto job = std::make_unique<RenderJob>();
+    job->kind = RenderJob::Kind::Export;
+    job->outputPath = savePath.toStdString();
+    job->image = imageLoader_->getPlane();
+    job->cache = renderCache_;
 
     try {
-        std::vector<float> finalAudio;
-        int sampleRate = 0;
-        int channels = 0;
-        QString errorMessage;
-
-        if (!generateAudio(finalAudio, sampleRate, channels, &errorMessage, &progressDialog)) {
-            const std::string message = errorMessage.isEmpty()
-                ? "Failed to render audio."
-                : errorMessage.toStdString();
-            throw std::runtime_error(message);
-        }
-
-        // Parse bit depth
-        BitDepth bitDepth = BitDepth::Int16;
-        const int bitDepthIdx = bitDepthCombo_->currentIndex();
-        if (bitDepthIdx == 0) bitDepth = BitDepth::Int16;
-        else if (bitDepthIdx == 1) bitDepth = BitDepth::Int24;
-        else if (bitDepthIdx == 2) bitDepth = BitDepth::Float32;
-
-        // Step 5: Write WAV file
-        progressDialog.setValue(95);
-        progressDialog.setLabelText("Writing WAV file...");
-        QApplication::processEvents();
-
-        std::cout << "\n=== Writing WAV file ===" << std::endl;
-        WavWriter wavWriter;
-        bool success = wavWriter.write(
-            savePath.toStdString(),
-            finalAudio,
-            channels,
-            sampleRate,
-            bitDepth
-        );
-
-        progressDialog.setValue(100);
-        QApplication::processEvents();
-
-        if (success) {
-            const double durationSeconds = (sampleRate > 0 && channels > 0)
-                ? (finalAudio.size() / static_cast<double>(sampleRate * channels))
-                : 0.0;
-            std::cout << "\n=== Render Complete ===" << std::endl;
-            QMessageBox::information(this, "Success",
-                QString("Audio rendered successfully!\n\nFile: %1\nDuration: %2 seconds")
-                    .arg(savePath)
-                    .arg(durationSeconds, 0, 'f', 2));
-        } else {
-            throw std::runtime_error("Failed to write WAV file");
-        }
-
+        job->settings = collectRenderSettings();
     } catch (const std::exception& e) {
         std::cerr << "Render error: " << e.what() << std::endl;
         QMessageBox::critical(this, "Render Error",
             QString("Failed to render audio:\n%1").arg(e.what()));
+        return;
     }
 
-    // Re-enable UI
-    setUIEnabled(true);
-    progressBar_->setValue(0);
+    // Stream when asked to, or when the whole-signal path would exceed the budget
+    const RenderEstimate estimate = RenderEstimator::estimate(
+        job->settings, imageLoader_->getWidth(), imageLoader_->getHeight());
+    const bool overBudget = RenderEstimator::shouldStream(estimate, memoryBudgetBytes());
+    std::cout << "Predicted memory: " << RenderEstimator::formatBytes(estimate.inMemoryBytes)
+              << " in memory, " << RenderEstimator::formatBytes(estimate.streamingBytes)
+              << " streaming; CPU ~" << estimate.cpuSeconds << " s" << std::endl;
+    if (overBudget && !streamingCheck_->isChecked()) {
+        std::cout << "Over the " << memoryBudgetSpin_->value()
+                  << " MB memory budget, switching to streaming render" << std::endl;
+    }
+    job->streaming = streamingCheck_->isChecked() || overBudget;
+
+    startRenderJob(std::move(job));
 }
 
 void MainWindow::onCancel() {
-    // TODO: Implement in STEP 5
+    if (!renderJob_) {
+        return;
+    }
+
+    // Griffin-Lim and the STFT poll the token, so the worker stops within one iteration
+    std::cout << "Cancelling render..." << std::endl;
+    renderJob_->cancel.store(true, std::memory_order_relaxed);
+    cancelButton_->setEnabled(false);
+    if (renderJob_->stream) {
+        stopPreviewPlayback();
+    }
 }
 
 void MainWindow::setUIEnabled(bool enabled) {
@@ -926,9 +1587,7 @@ void MainWindow::dragEnterEvent(QDragEnterEvent* event) {
         // Check if any of the URLs is an image file
         for (const QUrl& url : event->mimeData()->urls()) {
             QString path = url.toLocalFile();
-            if (path.endsWith(".png", Qt::CaseInsensitive) ||
-                path.endsWith(".jpg", Qt::CaseInsensitive) ||
-                path.endsWith(".jpeg", Qt::CaseInsensitive)) {
+            if (isSupportedImagePath(path)) {
                 event->acceptProposedAction();
                 std::cout << "Accepting drag: " << path.toStdString() << std::endl;
                 return;
@@ -946,9 +1605,7 @@ void MainWindow::dropEvent(QDropEvent* event) {
             QString path = url.toLocalFile();
             std::cout << "Dropped file: " << path.toStdString() << std::endl;
 
-            if (path.endsWith(".png", Qt::CaseInsensitive) ||
-                path.endsWith(".jpg", Qt::CaseInsensitive) ||
-                path.endsWith(".jpeg", Qt::CaseInsensitive)) {
+            if (isSupportedImagePath(path)) {
                 loadImageFile(path);
                 event->acceptProposedAction();
                 return; // Only load first valid image
@@ -12,14 +12,23 @@
 #include <QHBoxLayout>
 #include <QGroupBox>
 #include <QPixmap>
+#include <atomic>
 #include <memory>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "core/ImageLoader.h"
+#include "core/PreviewStream.h"
+#include "core/RenderCache.h"
+#include "core/RenderPipeline.h"
+#include "core/RenderProgress.h"
+#include "core/SeekRenderer.h"
 #include "app/ImagePreviewWidget.h"
+#include "app/PreviewAudioDevice.h"
 #include <QAudioSink>
-#include <QBuffer>
 #include <QProgressDialog>
+#include <QThreadPool>
 #include <QTimer>
 
 namespace img2spec {
@@ -36,6 +45,8 @@ private slots:
     void onRender();
     void onPreview();
     void onCancel();
+    void onRenderPoll();
+    void onSeek(double fraction);
 
 protected:
     void dragEnterEvent(QDragEnterEvent* event) override;
@@ -48,12 +59,61 @@ private:
     void updateDurationEstimate();
     void setUIEnabled(bool enabled);
     void loadImageFile(const QString& path);
-    bool generateAudio(std::vector<float>& finalAudio,
-                       int& sampleRate,
-                       int& channels,
-                       QString* errorMessage,
-                       QProgressDialog* progressDialog);
-    void startPreviewPlayback(const std::vector<float>& audio, int sampleRate, int channels);
+    // Render settings from the parameter widgets; throws on invalid input
+    RenderSettings collectRenderSettings() const;
+    // Second line of the duration label: predicted memory and CPU time
+    QString renderCostText() const;
+    size_t memoryBudgetBytes() const;
+    // Preview from startFraction of the duration (0: from the start)
+    void startPreview(double startFraction);
+    // A render running on the worker thread. The worker reads the inputs,
+    // publishes through progress/cancel, and fills the results before
+    // setting finished (release); the UI reads them after joining.
+    struct RenderJob {
+        enum class Kind { Preview, Export };
+
+        Kind kind = Kind::Export;
+        RenderSettings settings;
+        GrayscalePlane image;     // shallow copy, shares the loaded pixels
+        std::string outputPath;   // Export only
+        bool streaming = false;
+        std::shared_ptr<PreviewStream> stream; // progressive preview: played while rendering
+        RenderSettings streamSettings;         // what goes into stream (settings or a draft)
+        bool refine = false;                   // then render settings in full into audio
+        std::shared_ptr<RenderCache> cache;    // stage results shared across jobs (in-memory renders)
+        double startFraction = 0.0;            // Preview: playback starts at this share of the duration
+        std::shared_ptr<SegmentCache> segments; // progressive preview: stretches kept for seeking
+
+        std::atomic<bool> cancel{false};
+        std::atomic<bool> finished{false};
+        RenderProgress progress;
+
+        bool success = false;
+        std::string errorMessage;
+        std::shared_ptr<const std::vector<float>> audio; // mono post-processed output
+        double durationSec = 0.0;
+
+        std::thread thread;
+    };
+
+    void startRenderJob(std::unique_ptr<RenderJob> job);
+    void finishRenderJob();
+    static void runRenderJob(RenderJob& job);
+    // Whole-signal render; finalAudio is mono at settings.spectrogram.sampleRate.
+    // Stages whose inputs match the cache are reused (cache may be null).
+    // Runs on the worker thread, so it must not touch any widget.
+    static bool generateAudio(const RenderSettings& settings,
+                              const GrayscalePlane& image,
+                              RenderCache* cache,
+                              std::shared_ptr<const std::vector<float>>& finalAudio,
+                              RenderProgress* progress,
+                              const std::atomic<bool>* cancelFlag,
+                              std::string* errorMessage);
+    // Creates previewSink_ for the device's preferred format (Float, else Int16)
+    bool openPreviewSink(int sampleRate, int channels, QAudioFormat::SampleFormat* sampleFormatOut);
+    void beginPreviewPlayback(QIODevice* source, int sampleRate, double durationSec, double startSec = 0.0);
+    void startPreviewPlayback(std::shared_ptr<const std::vector<float>> audio, int sampleRate, int channels,
+                              double startFraction = 0.0);
     void stopPreviewPlayback();
     void updatePreviewPosition();
 
@@ -63,12 +123,16 @@ private:
     QPushButton* openButton_;
     QPushButton* renderButton_;
     QPushButton* previewButton_;
+    QCheckBox* progressivePreviewCheck_;
+    QComboBox* previewQualityCombo_;
+    QComboBox* draftSpeedCombo_;
     QPushButton* cancelButton_;
     QProgressBar* progressBar_;
 
     // Parameters
     QComboBox* sampleRateCombo_;
     QComboBox* bitDepthCombo_;
+    QComboBox* ditherCombo_;
     QComboBox* fftSizeCombo_;
     QComboBox* hopSizeCombo_;
     QComboBox* freqScaleCombo_;
@@ -77,10 +141,15 @@ private:
     QDoubleSpinBox* minDbSpin_;
     QDoubleSpinBox* gammaSpin_;
     QSpinBox* iterationsSpin_;
+    QComboBox* normalizeModeCombo_;
+    QLabel* normalizeTargetLabel_;
     QDoubleSpinBox* normalizeTargetSpin_;
     QDoubleSpinBox* outputGainSpin_;
     QCheckBox* limiterCheck_;
+    QCheckBox* truePeakCheck_;
     QCheckBox* stereoCheck_;
+    QCheckBox* streamingCheck_;
+    QSpinBox* memoryBudgetSpin_;
     QCheckBox* useTargetDurationCheck_;
     QDoubleSpinBox* targetDurationSpin_;
 
@@ -88,11 +157,25 @@ private:
 
     // Data
     std::unique_ptr<ImageLoader> imageLoader_;
+    std::shared_ptr<RenderCache> renderCache_; // stage results of in-memory renders
+    std::shared_ptr<SegmentCache> segmentCache_; // progressive preview output, reused when seeking
     QString currentImagePath_;
     QAudioSink* previewSink_;
-    QBuffer* previewBuffer_;
+    PreviewAudioDevice* previewDevice_;
     QTimer* previewPositionTimer_;
     double previewDurationSec_ = 0.0;
+    double previewStartSec_ = 0.0;     // signal time of the first sample played
+    int previewSampleRate_ = 0;
+    double pendingSeekFraction_ = -1.0; // seek waiting for the running preview to stop
+
+    // Background render
+    std::unique_ptr<RenderJob> renderJob_;
+    QTimer* renderPollTimer_;
+    QProgressDialog* renderProgressDialog_;
+
+    // Preview image construction (off the GUI thread)
+    QThreadPool* previewThreadPool_;
+    int previewGeneration_ = 0;
 };
 
 } // namespace img2spec
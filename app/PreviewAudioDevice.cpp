@@ -0,0 +1,167 @@
+#include "app/PreviewAudioDevice.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace img2spec {
+
+namespace {
+
+// Frames converted per step: keeps source, scratch and output in L1/L2
+constexpr size_t kChunkFrames = 4096;
+
+// Write each mono sample to all channels of an interleaved frame
+template <typename T>
+void duplicateChannels(const T* in, size_t numFrames, int channels, T* out) {
+    if (channels == 2) {
+        for (size_t i = 0; i < numFrames; ++i) {
+            out[2 * i] = in[i];
+            out[2 * i + 1] = in[i];
+        }
+        return;
+    }
+    for (size_t i = 0; i < numFrames; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            out[i * channels + c] = in[i];
+        }
+    }
+}
+
+qint64 bytesPerFrameFor(int channels, QAudioFormat::SampleFormat sampleFormat) {
+    const size_t sampleBytes = (sampleFormat == QAudioFormat::Float) ? sizeof(float) : sizeof(int16_t);
+    return static_cast<qint64>(std::max(1, channels) * sampleBytes);
+}
+
+} // namespace
+
+PreviewAudioDevice::PreviewAudioDevice(std::shared_ptr<const std::vector<float>> audio,
+                                       int channels,
+                                       QAudioFormat::SampleFormat sampleFormat,
+                                       QObject* parent)
+    : QIODevice(parent)
+    , channels_(std::max(1, channels))
+    , sampleFormat_(sampleFormat)
+    , bytesPerFrame_(bytesPerFrameFor(channels, sampleFormat))
+    , quantizer_(16, 1)
+    , audio_(std::move(audio))
+{
+}
+
+PreviewAudioDevice::PreviewAudioDevice(std::shared_ptr<PreviewStream> stream,
+                                       int channels,
+                                       QAudioFormat::SampleFormat sampleFormat,
+                                       QObject* parent)
+    : QIODevice(parent)
+    , stream_(std::move(stream))
+    , channels_(std::max(1, channels))
+    , sampleFormat_(sampleFormat)
+    , bytesPerFrame_(bytesPerFrameFor(channels, sampleFormat))
+    , quantizer_(16, 1)
+{
+}
+
+PreviewAudioDevice::~PreviewAudioDevice() {
+    // Let a render still waiting for queue space give up
+    if (stream_) {
+        stream_->close();
+    }
+}
+
+void PreviewAudioDevice::setRefinedAudio(std::shared_ptr<const std::vector<float>> audio) {
+    std::atomic_store(&pendingAudio_, std::move(audio));
+}
+
+qint64 PreviewAudioDevice::bytesAvailable() const {
+    if (audio_) {
+        const size_t remaining = audio_->size() - std::min(position_, audio_->size());
+        return static_cast<qint64>(remaining) * bytesPerFrame_ + QIODevice::bytesAvailable();
+    }
+    if (stream_->atEnd()) {
+        return QIODevice::bytesAvailable();
+    }
+    // Underruns are filled with silence, so there is always something to read
+    const qint64 queued = static_cast<qint64>(stream_->getQueuedSamples());
+    return std::max<qint64>(queued, kChunkFrames) * bytesPerFrame_ + QIODevice::bytesAvailable();
+}
+
+bool PreviewAudioDevice::atEnd() const {
+    if (audio_) {
+        return position_ >= audio_->size() && QIODevice::atEnd();
+    }
+    return stream_->atEnd() && QIODevice::atEnd();
+}
+
+void PreviewAudioDevice::writeFrames(const float* mono, size_t numFrames, char* out) {
+    if (sampleFormat_ == QAudioFormat::Float) {
+        float* dst = reinterpret_cast<float*>(out);
+        if (channels_ == 1) {
+            std::memcpy(dst, mono, numFrames * sizeof(float));
+        } else {
+            duplicateChannels(mono, numFrames, channels_, dst);
+        }
+        return;
+    }
+
+    // Convert once per frame, then duplicate the 16-bit values
+    int16_t* dst = reinterpret_cast<int16_t*>(out);
+    if (channels_ == 1) {
+        quantizer_.quantize(mono, numFrames, dst);
+        return;
+    }
+    pcm16_.resize(numFrames);
+    quantizer_.quantize(mono, numFrames, pcm16_.data());
+    duplicateChannels(pcm16_.data(), numFrames, channels_, dst);
+}
+
+qint64 PreviewAudioDevice::readData(char* data, qint64 maxSize) {
+    const size_t numFrames = static_cast<size_t>(maxSize / bytesPerFrame_);
+    if (numFrames == 0) {
+        return 0;
+    }
+
+    if (auto refined = std::atomic_exchange(&pendingAudio_, std::shared_ptr<const std::vector<float>>())) {
+        // The draft is no longer needed; a render still filling it stops
+        audio_ = std::move(refined);
+        if (stream_) {
+            stream_->close();
+        }
+    }
+
+    size_t written = 0;
+    while (written < numFrames) {
+        const size_t chunk = std::min(kChunkFrames, numFrames - written);
+        const float* source = nullptr;
+        size_t available = 0;
+
+        if (audio_) {
+            // Buffer mode: convert straight from the shared render
+            const size_t begin = std::min(position_, audio_->size());
+            available = std::min(chunk, audio_->size() - begin);
+            source = audio_->data() + begin;
+            position_ += available;
+        } else {
+            scratch_.resize(chunk);
+            available = stream_->read(scratch_.data(), chunk);
+            position_ += available;
+            if (available < chunk && !stream_->atEnd()) {
+                std::fill(scratch_.begin() + available, scratch_.begin() + chunk, 0.0f);
+                underrunFrames_.fetch_add(static_cast<qint64>(chunk - available), std::memory_order_relaxed);
+                available = chunk;
+            }
+            source = scratch_.data();
+        }
+
+        if (available == 0) {
+            break;
+        }
+        writeFrames(source, available, data + written * bytesPerFrame_);
+        written += available;
+    }
+    return static_cast<qint64>(written) * bytesPerFrame_;
+}
+
+qint64 PreviewAudioDevice::writeData(const char*, qint64) {
+    return -1;
+}
+
+} // namespace img2spec
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QAudioFormat>
+#include <QIODevice>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "core/PreviewStream.h"
+#include "core/Quantizer.h"
+
+namespace img2spec {
+
+// Pull-mode source for QAudioSink that plays mono preview audio without
+// copying it into a QByteArray first. readData() converts to the sink's
+// sample format and duplicates to its channel count in cache-sized chunks,
+// straight from one of two sources:
+//
+// - Buffer mode: a finished render, shared with the caller (zero copy)
+// - Stream mode: a PreviewStream that is still being rendered. When the
+//   render falls behind the playhead, silence is inserted instead of running
+//   dry, which would put the sink into IdleState.
+//
+// Draft previews: setRefinedAudio() hands over the final render; playback
+// switches to it at the next readData() call (a sink buffer boundary),
+// continuing at the same sample position.
+class PreviewAudioDevice : public QIODevice {
+    Q_OBJECT
+
+public:
+    PreviewAudioDevice(std::shared_ptr<const std::vector<float>> audio,
+                       int channels,
+                       QAudioFormat::SampleFormat sampleFormat,
+                       QObject* parent = nullptr);
+    PreviewAudioDevice(std::shared_ptr<PreviewStream> stream,
+                       int channels,
+                       QAudioFormat::SampleFormat sampleFormat,
+                       QObject* parent = nullptr);
+    ~PreviewAudioDevice();
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+    bool atEnd() const override;
+
+    // Frames of silence inserted so far (subtract from the sink position)
+    qint64 getUnderrunFrames() const { return underrunFrames_.load(std::memory_order_relaxed); }
+
+    // Mono at the stream's sample rate; may be called from any thread
+    void setRefinedAudio(std::shared_ptr<const std::vector<float>> audio);
+
+    // Seek playback: the first frame played is frame of the signal (buffer
+    // mode), or the stream starts at it. Call before the sink starts pulling.
+    void setStartFrame(size_t frame) { position_ = frame; }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    // Convert numFrames mono samples to the sink format at out
+    void writeFrames(const float* mono, size_t numFrames, char* out);
+
+    std::shared_ptr<PreviewStream> stream_;
+    const int channels_;
+    const QAudioFormat::SampleFormat sampleFormat_;
+    const qint64 bytesPerFrame_;
+    Quantizer quantizer_;          // Int16: branch-free clamp and round, vectorized
+    std::vector<float> scratch_;   // stream mode: samples read from the queue
+    std::vector<int16_t> pcm16_;   // Int16 multichannel: converted before duplication
+    std::atomic<qint64> underrunFrames_{0};
+
+    // Rendered buffer being played. Refinements are published through
+    // pendingAudio_ with atomic_store and picked up by readData(), which
+    // owns audio_ and position_.
+    std::shared_ptr<const std::vector<float>> pendingAudio_;
+    std::shared_ptr<const std::vector<float>> audio_;
+    size_t position_ = 0; // signal frame delivered next (silence not counted)
+};
+
+} // namespace img2spec
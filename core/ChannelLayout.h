@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace img2spec {
+
+/**
+ * Read-only view of sample memory as N logical channels.
+ *
+ * Each channel is a base pointer plus a stride shared by all channels, which
+ * covers the three layouts used in the app without copying:
+ * - broadcast(): one mono buffer presented as N identical channels
+ * - interleaved(): [L0, R0, L1, R1, ...]
+ * - planar(): one buffer per channel
+ *
+ * Consumers (WAV writer, audio sink) interleave on the fly in their output
+ * loops, so a mono render exported as stereo needs no second buffer.
+ */
+class AudioView {
+public:
+    AudioView() = default;
+
+    static AudioView broadcast(const float* mono, size_t numFrames, int channels) {
+        AudioView view;
+        view.numFrames_ = numFrames;
+        view.stride_ = 1;
+        view.channels_.assign(std::max(1, channels), mono);
+        return view;
+    }
+
+    static AudioView interleaved(const float* data, size_t numFrames, int channels) {
+        AudioView view;
+        view.numFrames_ = numFrames;
+        view.stride_ = static_cast<size_t>(std::max(1, channels));
+        for (int c = 0; c < std::max(1, channels); ++c) {
+            view.channels_.push_back(data + c);
+        }
+        return view;
+    }
+
+    static AudioView planar(const std::vector<const float*>& planes, size_t numFrames) {
+        AudioView view;
+        view.numFrames_ = numFrames;
+        view.stride_ = 1;
+        view.channels_ = planes;
+        return view;
+    }
+
+    bool isEmpty() const { return numFrames_ == 0 || channels_.empty(); }
+    size_t getNumFrames() const { return numFrames_; }
+    int getNumChannels() const { return static_cast<int>(channels_.size()); }
+    size_t getNumSamples() const { return numFrames_ * channels_.size(); }
+
+    float sample(size_t frame, int channel) const {
+        return channels_[channel][frame * stride_];
+    }
+
+    // Write frames [frame0, frame0 + numFrames) interleaved to out,
+    // converting each sample with convert (float -> T)
+    template <typename T, typename Convert>
+    void interleave(size_t frame0, size_t numFrames, T* out, Convert convert) const {
+        const size_t numChannels = channels_.size();
+        if (numChannels == 1) {
+            const float* src = channels_[0] + frame0 * stride_;
+            for (size_t i = 0; i < numFrames; ++i) {
+                out[i] = convert(src[i * stride_]);
+            }
+            return;
+        }
+        for (size_t c = 0; c < numChannels; ++c) {
+            const float* src = channels_[c] + frame0 * stride_;
+            T* dst = out + c;
+            for (size_t i = 0; i < numFrames; ++i) {
+                dst[i * numChannels] = convert(src[i * stride_]);
+            }
+        }
+    }
+
+    void interleave(size_t frame0, size_t numFrames, float* out) const {
+        interleave(frame0, numFrames, out, [](float s) { return s; });
+    }
+
+private:
+    std::vector<const float*> channels_;
+    size_t stride_ = 1;
+    size_t numFrames_ = 0;
+};
+
+} // namespace img2spec
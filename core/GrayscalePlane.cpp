@@ -0,0 +1,185 @@
+#include "core/GrayscalePlane.h"
+#include "core/Parallel.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace img2spec {
+
+namespace {
+
+// ITU-R BT.709 luminance weights in Q16 (sum is exactly 65536)
+constexpr uint32_t kWeightR = 13933; // 0.2126
+constexpr uint32_t kWeightG = 46871; // 0.7152
+constexpr uint32_t kWeightB = 4732;  // 0.0722
+constexpr uint32_t kRound = 1u << 15;
+
+template <int Channels, typename T>
+void convertKernel(const T* __restrict src, size_t numPixels, T* __restrict dst) {
+    for (size_t i = 0; i < numPixels; ++i) {
+        const T* px = src + i * Channels;
+        if constexpr (Channels < 3) {
+            dst[i] = px[0];
+        } else {
+            dst[i] = static_cast<T>(
+                (kWeightR * px[0] + kWeightG * px[1] + kWeightB * px[2] + kRound) >> 16);
+        }
+    }
+}
+
+template <typename T>
+void convertDispatch(const T* src, int channels, size_t numPixels, T* dst) {
+    switch (channels) {
+        case 1:
+            std::memcpy(dst, src, numPixels * sizeof(T));
+            break;
+        case 2:
+            convertKernel<2>(src, numPixels, dst);
+            break;
+        case 3:
+            convertKernel<3>(src, numPixels, dst);
+            break;
+        default:
+            convertKernel<4>(src, numPixels, dst);
+            break;
+    }
+}
+
+template <typename T>
+void readRowTyped(const T* row, int x0, int x1, float scale, float* out) {
+    for (int x = x0; x < x1; ++x) {
+        out[x - x0] = row[x] * scale;
+    }
+}
+
+} // namespace
+
+void convertToGrayscale(const uint8_t* src, int channels, size_t numPixels, uint8_t* dst) {
+    convertDispatch(src, channels, numPixels, dst);
+}
+
+void convertToGrayscale(const uint16_t* src, int channels, size_t numPixels, uint16_t* dst) {
+    convertDispatch(src, channels, numPixels, dst);
+}
+
+size_t GrayscalePlane::bytesPerPixel(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::UInt8: return 1;
+        case PixelFormat::UInt16: return 2;
+        case PixelFormat::Float32: return 4;
+    }
+    return 1;
+}
+
+float GrayscalePlane::normalizationScale(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::UInt8: return 1.0f / 255.0f;
+        case PixelFormat::UInt16: return 1.0f / 65535.0f;
+        case PixelFormat::Float32: return 1.0f;
+    }
+    return 1.0f;
+}
+
+GrayscalePlane GrayscalePlane::allocate(int width, int height, PixelFormat format) {
+    GrayscalePlane plane;
+    const size_t numBytes = static_cast<size_t>(width) * height * bytesPerPixel(format);
+    std::shared_ptr<uint8_t> buffer(new uint8_t[numBytes], std::default_delete<uint8_t[]>());
+
+    plane.owner_ = buffer;
+    plane.data_ = buffer.get();
+    plane.mutableData_ = buffer.get();
+    plane.width_ = width;
+    plane.height_ = height;
+    plane.format_ = format;
+    return plane;
+}
+
+GrayscalePlane GrayscalePlane::wrap(
+    const void* data,
+    int width,
+    int height,
+    PixelFormat format,
+    std::shared_ptr<const void> owner
+) {
+    GrayscalePlane plane;
+    plane.owner_ = std::move(owner);
+    plane.data_ = data;
+    plane.width_ = width;
+    plane.height_ = height;
+    plane.format_ = format;
+    return plane;
+}
+
+float GrayscalePlane::getPixel(int x, int y) const {
+    if (x < 0 || x >= width_ || y < 0 || y >= height_) {
+        return 0.0f;
+    }
+
+    switch (format_) {
+        case PixelFormat::UInt8: return row<uint8_t>(y)[x] * (1.0f / 255.0f);
+        case PixelFormat::UInt16: return row<uint16_t>(y)[x] * (1.0f / 65535.0f);
+        case PixelFormat::Float32: return row<float>(y)[x];
+    }
+    return 0.0f;
+}
+
+void GrayscalePlane::readRow(int y, int x0, int x1, float* out) const {
+    const float scale = normalizationScale(format_);
+    switch (format_) {
+        case PixelFormat::UInt8:
+            readRowTyped(row<uint8_t>(y), x0, x1, scale, out);
+            break;
+        case PixelFormat::UInt16:
+            readRowTyped(row<uint16_t>(y), x0, x1, scale, out);
+            break;
+        case PixelFormat::Float32:
+            std::copy(row<float>(y) + x0, row<float>(y) + x1, out);
+            break;
+    }
+}
+
+void GrayscalePlane::downsampleToGray8(int outWidth, int outHeight, uint8_t* out, size_t outStride) const {
+    if (isEmpty() || outWidth <= 0 || outHeight <= 0) {
+        return;
+    }
+
+    // Source column span of every output column: [x0, x1), at least one pixel
+    std::vector<int> columnStart(outWidth + 1);
+    for (int ox = 0; ox <= outWidth; ++ox) {
+        columnStart[ox] = static_cast<int>(static_cast<int64_t>(ox) * width_ / outWidth);
+    }
+
+    parallelFor(0, outHeight, [&](int oy0, int oy1) {
+        std::vector<float> rowBuffer(width_);
+        std::vector<float> rowSum(width_);
+
+        for (int oy = oy0; oy < oy1; ++oy) {
+            const int y0 = static_cast<int>(static_cast<int64_t>(oy) * height_ / outHeight);
+            const int y1 = std::max(y0 + 1, static_cast<int>(static_cast<int64_t>(oy + 1) * height_ / outHeight));
+
+            // Vertical box sum of the covered rows
+            readRow(y0, 0, width_, rowSum.data());
+            for (int y = y0 + 1; y < y1; ++y) {
+                readRow(y, 0, width_, rowBuffer.data());
+                for (int x = 0; x < width_; ++x) {
+                    rowSum[x] += rowBuffer[x];
+                }
+            }
+
+            // Horizontal box average, scaled to 0..255
+            uint8_t* dst = out + static_cast<size_t>(oy) * outStride;
+            for (int ox = 0; ox < outWidth; ++ox) {
+                const int x0 = columnStart[ox];
+                const int x1 = std::max(x0 + 1, columnStart[ox + 1]);
+                float sum = 0.0f;
+                for (int x = x0; x < x1; ++x) {
+                    sum += rowSum[x];
+                }
+                const float value = sum * (255.0f / (static_cast<float>(x1 - x0) * (y1 - y0))) + 0.5f;
+                dst[ox] = static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, value)));
+            }
+        }
+    }, 16);
+}
+
+} // namespace img2spec
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace img2spec {
+
+enum class PixelFormat {
+    UInt8,   // 0..255
+    UInt16,  // 0..65535
+    Float32  // 0.0..1.0
+};
+
+/**
+ * GrayscalePlane: Row-major grayscale image in compact storage
+ * - 8/16-bit sources stay integer; conversion to float happens on access
+ * - Either owns its pixels or wraps external memory (e.g. a mapped file)
+ * - Copies are shallow and share the same pixels
+ */
+class GrayscalePlane {
+public:
+    GrayscalePlane() = default;
+
+    /**
+     * Allocate an owned, uninitialized plane
+     */
+    static GrayscalePlane allocate(int width, int height, PixelFormat format);
+
+    /**
+     * Wrap external pixels without copying
+     * @param owner Optional handle keeping the memory alive
+     */
+    static GrayscalePlane wrap(
+        const void* data,
+        int width,
+        int height,
+        PixelFormat format,
+        std::shared_ptr<const void> owner = nullptr
+    );
+
+    bool isEmpty() const { return data_ == nullptr; }
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    PixelFormat getFormat() const { return format_; }
+
+    size_t getBytesPerPixel() const { return bytesPerPixel(format_); }
+    size_t getSizeBytes() const { return static_cast<size_t>(width_) * height_ * getBytesPerPixel(); }
+
+    const void* data() const { return data_; }
+
+    /**
+     * Writable pixels (owned planes only, nullptr for wrapped memory)
+     */
+    void* mutableData() { return mutableData_; }
+
+    template <typename T>
+    const T* row(int y) const {
+        return static_cast<const T*>(data_) + static_cast<size_t>(y) * width_;
+    }
+
+    /**
+     * Get grayscale value at position (with bounds checking)
+     * @return Grayscale value [0.0, 1.0], 0 outside the plane
+     */
+    float getPixel(int x, int y) const;
+
+    /**
+     * Convert pixels [x0, x1) of row y to normalized float
+     */
+    void readRow(int y, int x0, int x1, float* out) const;
+
+    /**
+     * Area-average the plane down to outWidth x outHeight 8-bit gray
+     * (display previews). Each output pixel is the mean of the source pixels
+     * it covers; when enlarging, pixels are replicated. Rows are processed
+     * in parallel.
+     * @param outStride Bytes between output rows
+     */
+    void downsampleToGray8(int outWidth, int outHeight, uint8_t* out, size_t outStride) const;
+
+    /**
+     * Factor mapping stored samples to [0.0, 1.0]
+     */
+    static float normalizationScale(PixelFormat format);
+    static size_t bytesPerPixel(PixelFormat format);
+
+private:
+    std::shared_ptr<const void> owner_;
+    const void* data_ = nullptr;
+    void* mutableData_ = nullptr;
+    int width_ = 0;
+    int height_ = 0;
+    PixelFormat format_ = PixelFormat::UInt8;
+};
+
+/**
+ * Convert interleaved pixels to grayscale (ITU-R BT.709, Q16 fixed point)
+ * - channels: 1 (gray), 2 (gray + alpha), 3 (RGB), 4 (RGBA); alpha is ignored
+ * - Kernels are specialized per channel count with branch-free inner loops
+ */
+void convertToGrayscale(const uint8_t* src, int channels, size_t numPixels, uint8_t* dst);
+void convertToGrayscale(const uint16_t* src, int channels, size_t numPixels, uint16_t* dst);
+
+} // namespace img2spec
@@ -1,11 +1,15 @@
 #include "core/GriffinLim.h"
 #include "core/Stft.h"
+#include <algorithm>
 #include <random>
 #include <iostream>
 
 namespace img2spec {
 
-GriffinLim::GriffinLim() {}
+GriffinLim::GriffinLim()
+    : rng_(std::random_device{}())
+{
+}
 GriffinLim::~GriffinLim() {}
 
 void GriffinLim::initializeRandomPhase(
@@ -13,15 +17,13 @@ void GriffinLim::initializeRandomPhase(
     int numFrames,
     int numBins
 ) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
     std::uniform_real_distribution<float> dist(0.0f, 2.0f * M_PI);
 
     phase.resize(numFrames);
     for (int t = 0; t < numFrames; ++t) {
         phase[t].resize(numBins);
         for (int k = 0; k < numBins; ++k) {
-            phase[t][k] = dist(gen);
+            phase[t][k] = dist(rng_);
         }
     }
 }
@@ -31,15 +33,106 @@ std::vector<float> GriffinLim::reconstruct(
     Stft& stft,
     int numIterations,
     ProgressCallback progressCallback,
-    bool* cancelFlag
+    const std::atomic<bool>* cancelFlag
 ) {
     if (magnitudeSpectrogram.empty()) {
         std::cerr << "GriffinLim: Empty magnitude spectrogram" << std::endl;
         return {};
     }
 
-    const int numFrames = magnitudeSpectrogram.size();
-    const int numBins = magnitudeSpectrogram[0].size();
+    std::vector<const float*> frames(magnitudeSpectrogram.size());
+    for (size_t t = 0; t < frames.size(); ++t) {
+        frames[t] = magnitudeSpectrogram[t].data();
+    }
+
+    return reconstructFrames(frames, static_cast<int>(magnitudeSpectrogram[0].size()),
+                             stft, numIterations, progressCallback, cancelFlag);
+}
+
+std::vector<float> GriffinLim::reconstruct(
+    const float* magnitude,
+    int numFrames,
+    int numBins,
+    Stft& stft,
+    int numIterations,
+    ProgressCallback progressCallback,
+    const std::atomic<bool>* cancelFlag
+) {
+    if (!magnitude || numFrames <= 0 || numBins <= 0) {
+        std::cerr << "GriffinLim: Empty magnitude spectrogram" << std::endl;
+        return {};
+    }
+
+    std::vector<const float*> frames(numFrames);
+    for (int t = 0; t < numFrames; ++t) {
+        frames[t] = magnitude + static_cast<size_t>(t) * numBins;
+    }
+
+    return reconstructFrames(frames, numBins, stft, numIterations, progressCallback, cancelFlag);
+}
+
+std::vector<float> GriffinLim::reconstructWindow(
+    const std::vector<const float*>& magnitudeFrames,
+    int numBins,
+    Stft& stft,
+    int numIterations,
+    std::vector<std::vector<float>>& phase,
+    int numLockedFrames,
+    const std::atomic<bool>* cancelFlag
+) {
+    const int numFrames = static_cast<int>(magnitudeFrames.size());
+    if (numFrames == 0 || numBins <= 0) {
+        return {};
+    }
+
+    // Random phase for frames without a warm start
+    std::uniform_real_distribution<float> dist(0.0f, 2.0f * M_PI);
+    phase.resize(numFrames);
+    for (auto& row : phase) {
+        if (static_cast<int>(row.size()) != numBins) {
+            row.resize(numBins);
+            for (float& value : row) {
+                value = dist(rng_);
+            }
+        }
+    }
+
+    return iterate(magnitudeFrames, numBins, stft, numIterations, phase,
+                   std::min(numLockedFrames, numFrames), 0, false, nullptr, cancelFlag);
+}
+
+std::vector<float> GriffinLim::reconstructRegion(
+    const std::vector<const float*>& magnitudeFrames,
+    int numBins,
+    Stft& stft,
+    int numIterations,
+    std::vector<std::vector<float>>& phase,
+    int numLeadingLocked,
+    int numTrailingLocked,
+    ProgressCallback progressCallback,
+    const std::atomic<bool>* cancelFlag
+) {
+    const int numFrames = static_cast<int>(magnitudeFrames.size());
+    if (numFrames == 0 || numBins <= 0 || static_cast<int>(phase.size()) != numFrames) {
+        std::cerr << "GriffinLim: Region needs an initial phase for every frame" << std::endl;
+        return {};
+    }
+
+    const int leading = std::max(0, std::min(numLeadingLocked, numFrames));
+    const int trailing = std::max(0, std::min(numTrailingLocked, numFrames - leading));
+    return iterate(magnitudeFrames, numBins, stft, numIterations, phase,
+                   leading, trailing, false, progressCallback, cancelFlag);
+}
+
+std::vector<float> GriffinLim::reconstructFrames(
+    const std::vector<const float*>& magnitudeFrames,
+    int numBins,
+    Stft& stft,
+    int numIterations,
+    ProgressCallback progressCallback,
+    const std::atomic<bool>* cancelFlag
+) {
+    const int numFrames = static_cast<int>(magnitudeFrames.size());
 
     std::cout << "GriffinLim: Starting reconstruction" << std::endl;
     std::cout << "  Frames: " << numFrames << ", Bins: " << numBins << std::endl;
@@ -49,37 +142,67 @@ std::vector<float> GriffinLim::reconstruct(
     std::vector<std::vector<float>> phase;
     initializeRandomPhase(phase, numFrames, numBins);
 
+    std::vector<float> audio = iterate(magnitudeFrames, numBins, stft, numIterations, phase, 0, 0,
+                                       true, progressCallback, cancelFlag);
+
+    std::cout << "GriffinLim: Reconstruction complete. Output length: " << audio.size() << " samples" << std::endl;
+
+    return audio;
+}
+
+std::vector<float> GriffinLim::iterate(
+    const std::vector<const float*>& magnitudeFrames,
+    int numBins,
+    Stft& stft,
+    int numIterations,
+    std::vector<std::vector<float>>& phase,
+    int numLockedFrames,
+    int numTrailingLocked,
+    bool verbose,
+    ProgressCallback progressCallback,
+    const std::atomic<bool>* cancelFlag
+) {
+    const int numFrames = static_cast<int>(magnitudeFrames.size());
+    const int unlockedEnd = numFrames - numTrailingLocked;
+
     // Create complex spectrogram from magnitude + phase
     std::vector<std::vector<std::complex<float>>> complexSpec(numFrames);
     for (int t = 0; t < numFrames; ++t) {
         complexSpec[t].resize(numBins);
         for (int k = 0; k < numBins; ++k) {
-            const float mag = magnitudeSpectrogram[t][k];
+            const float mag = magnitudeFrames[t][k];
             const float ph = phase[t][k];
             complexSpec[t][k] = std::polar(mag, ph);
         }
     }
 
+    // The STFT checks the flag per frame, so cancellation lands within one
+    // iteration; partial transforms are discarded
+    auto cancelled = [cancelFlag]() { return cancelFlag && cancelFlag->load(std::memory_order_relaxed); };
+    const std::atomic<bool>* previousCancelFlag = stft.getCancelFlag();
+    stft.setCancelFlag(cancelFlag);
+
     // Griffin-Lim iterations
     std::vector<float> audio;
-    for (int iter = 0; iter < numIterations; ++iter) {
-        // Check for cancellation
-        if (cancelFlag && *cancelFlag) {
-            std::cout << "GriffinLim: Cancelled at iteration " << iter << std::endl;
-            break;
-        }
-
+    int iter = 0;
+    for (; iter < numIterations; ++iter) {
         // 1) ISTFT: complex spectrogram -> time-domain signal
         audio = stft.inverse(complexSpec);
+        if (cancelled()) {
+            break;
+        }
 
         // 2) STFT: time-domain signal -> complex spectrogram
         auto newSpec = stft.forward(audio);
+        if (cancelled()) {
+            break;
+        }
 
-        // 3) Extract phase, but keep original magnitude
-        for (int t = 0; t < numFrames && t < static_cast<int>(newSpec.size()); ++t) {
+        // 3) Extract phase, but keep original magnitude (locked frames keep theirs)
+        for (int t = numLockedFrames; t < unlockedEnd && t < static_cast<int>(newSpec.size()); ++t) {
             for (int k = 0; k < numBins && k < static_cast<int>(newSpec[t].size()); ++k) {
                 const float newPhase = std::arg(newSpec[t][k]);
-                const float origMag = magnitudeSpectrogram[t][k];
+                const float origMag = magnitudeFrames[t][k];
                 complexSpec[t][k] = std::polar(origMag, newPhase);
             }
         }
@@ -90,15 +213,27 @@ std::vector<float> GriffinLim::reconstruct(
         }
 
         // Log progress every 10 iterations
-        if ((iter + 1) % 10 == 0 || iter == 0 || iter == numIterations - 1) {
+        if (verbose && ((iter + 1) % 10 == 0 || iter == 0 || iter == numIterations - 1)) {
             std::cout << "  Iteration " << (iter + 1) << "/" << numIterations << std::endl;
         }
     }
 
     // Final ISTFT
-    audio = stft.inverse(complexSpec);
+    if (!cancelled()) {
+        audio = stft.inverse(complexSpec);
+    }
+    stft.setCancelFlag(previousCancelFlag);
+    if (cancelled()) {
+        std::cout << "GriffinLim: Cancelled at iteration " << iter << std::endl;
+        return {};
+    }
 
-    std::cout << "GriffinLim: Reconstruction complete. Output length: " << audio.size() << " samples" << std::endl;
+    // Hand back the final phase (warm start for a following window)
+    for (int t = numLockedFrames; t < unlockedEnd; ++t) {
+        for (int k = 0; k < numBins; ++k) {
+            phase[t][k] = std::arg(complexSpec[t][k]);
+        }
+    }
 
     return audio;
 }
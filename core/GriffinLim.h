@@ -1,7 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include <functional>
+#include <random>
 
 namespace img2spec {
 
@@ -21,15 +23,83 @@ public:
         Stft& stft,
         int numIterations,
         ProgressCallback progressCallback = nullptr,
-        bool* cancelFlag = nullptr
+        const std::atomic<bool>* cancelFlag = nullptr
+    );
+
+    // Reconstruct from contiguous frame-major magnitudes (numFrames x numBins),
+    // e.g. a memory-mapped RawMatrix; the magnitudes are read in place.
+    std::vector<float> reconstruct(
+        const float* magnitude,
+        int numFrames,
+        int numBins,
+        Stft& stft,
+        int numIterations,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool>* cancelFlag = nullptr
+    );
+
+    // Reconstruct one window of a longer signal (block-wise rendering).
+    // phase: per-frame initial phase in radians; rows left empty start from
+    // random phase. Holds the final phase on return, to warm-start the next
+    // window. The first numLockedFrames keep their initial phase throughout,
+    // so the window joins audio that was already committed.
+    std::vector<float> reconstructWindow(
+        const std::vector<const float*>& magnitudeFrames,
+        int numBins,
+        Stft& stft,
+        int numIterations,
+        std::vector<std::vector<float>>& phase,
+        int numLockedFrames,
+        const std::atomic<bool>* cancelFlag = nullptr
+    );
+
+    // Re-solve the middle of an existing signal (region re-render). phase
+    // holds the initial phase of every frame (warm start) and the final phase
+    // on return. The first numLeadingLocked and last numTrailingLocked frames
+    // keep theirs, so the result joins the untouched audio on both sides.
+    std::vector<float> reconstructRegion(
+        const std::vector<const float*>& magnitudeFrames,
+        int numBins,
+        Stft& stft,
+        int numIterations,
+        std::vector<std::vector<float>>& phase,
+        int numLeadingLocked,
+        int numTrailingLocked,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool>* cancelFlag = nullptr
     );
 
 private:
+    std::vector<float> iterate(
+        const std::vector<const float*>& magnitudeFrames,
+        int numBins,
+        Stft& stft,
+        int numIterations,
+        std::vector<std::vector<float>>& phase,
+        int numLockedFrames,
+        int numTrailingLocked,
+        bool verbose,
+        ProgressCallback progressCallback,
+        const std::atomic<bool>* cancelFlag
+    );
+
+    std::vector<float> reconstructFrames(
+        const std::vector<const float*>& magnitudeFrames,
+        int numBins,
+        Stft& stft,
+        int numIterations,
+        ProgressCallback progressCallback,
+        const std::atomic<bool>* cancelFlag
+    );
+
+
     void initializeRandomPhase(
         std::vector<std::vector<float>>& phase,
         int numFrames,
         int numBins
     );
+
+    std::mt19937 rng_;
 };
 
 } // namespace img2spec
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace img2spec {
+
+// 64-bit non-cryptographic hashing for cache keys (file contents, pixel
+// data, render parameters). Not stable across versions: a persisted hash
+// (ImageCache's content hash) is only ever compared against one freshly
+// computed from the same input, so a changed hash function just means a
+// cache miss. Never look up persisted data by a hash alone.
+
+constexpr uint64_t kHashSeed = 0x9e3779b97f4a7c15ull;
+
+inline uint64_t hashMix(uint64_t h, uint64_t w) {
+    h ^= w * 0xff51afd7ed558ccdull;
+    h = (h << 31) | (h >> 33);
+    return h * 0xc4ceb9fe1a85ec53ull;
+}
+
+inline uint64_t hashBytes(const void* bytes, size_t size) {
+    const unsigned char* data = static_cast<const unsigned char*>(bytes);
+
+    // Four independent lanes keep the multiply chains overlapped
+    uint64_t lanes[4] = {kHashSeed, kHashSeed ^ 1, kHashSeed ^ 2, kHashSeed ^ 3};
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            uint64_t w;
+            std::memcpy(&w, data + i + lane * 8, 8);
+            lanes[lane] = hashMix(lanes[lane], w);
+        }
+    }
+
+    uint64_t h = static_cast<uint64_t>(size);
+    for (uint64_t lane : lanes) {
+        h = hashMix(h, lane);
+    }
+    for (; i < size; ++i) {
+        h = hashMix(h, data[i]);
+    }
+    return h;
+}
+
+// Fold a scalar (integer, enum, float, double, bool) into h
+template <typename T>
+uint64_t hashValue(uint64_t h, T value) {
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= 8, "hashValue takes scalars");
+    uint64_t w = 0;
+    std::memcpy(&w, &value, sizeof(T));
+    return hashMix(h, w);
+}
+
+} // namespace img2spec
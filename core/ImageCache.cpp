@@ -0,0 +1,223 @@
+#include "core/ImageCache.h"
+#include "core/Hash.h"
+#include "core/MappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+namespace img2spec {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char kMagic[4] = {'I', '2', 'S', 'C'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 64; // Keeps pixel data aligned in the mapping
+
+struct EntryHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+    uint32_t reserved;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    uint64_t contentHash;
+    uint64_t pathHash;
+};
+static_assert(sizeof(EntryHeader) <= kHeaderSize, "Cache header must fit the reserved space");
+
+bool sourceStat(const std::string& path, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    size = fs::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    const auto writeTime = fs::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    mtime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+    return true;
+}
+
+std::string canonicalPath(const std::string& path) {
+    std::error_code ec;
+    const fs::path canonical = fs::weakly_canonical(fs::path(path), ec);
+    return ec ? path : canonical.string();
+}
+
+} // namespace
+
+ImageCache::ImageCache(const std::string& directory)
+    : directory_(directory)
+{
+}
+
+ImageCache::~ImageCache() {}
+
+uint64_t ImageCache::hashFileContents(const std::string& path) {
+    MappedFile file;
+    if (!file.openReadOnly(path)) {
+        return 0;
+    }
+    return hashBytes(file.data(), file.size());
+}
+
+std::string ImageCache::entryPath(const std::string& sourcePath) const {
+    const std::string canonical = canonicalPath(sourcePath);
+    const uint64_t pathHash = hashBytes(canonical.data(), canonical.size());
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.i2sc", static_cast<unsigned long long>(pathHash));
+    return (fs::path(directory_) / name).string();
+}
+
+bool ImageCache::lookup(const std::string& sourcePath, GrayscalePlane& plane) const {
+    uint64_t sourceSize = 0;
+    int64_t sourceMtime = 0;
+    if (!sourceStat(sourcePath, sourceSize, sourceMtime)) {
+        return false;
+    }
+
+    auto entry = std::make_shared<MappedFile>();
+    if (!entry->openReadOnly(entryPath(sourcePath)) || entry->size() < kHeaderSize) {
+        return false;
+    }
+
+    EntryHeader header;
+    std::memcpy(&header, entry->data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, 4) != 0 || header.version != kVersion
+        || header.sourceSize != sourceSize || header.sourceMtime != sourceMtime
+        || header.format > static_cast<uint32_t>(PixelFormat::Float32)) {
+        return false;
+    }
+
+    const auto format = static_cast<PixelFormat>(header.format);
+    const uint64_t dataBytes = static_cast<uint64_t>(header.width) * header.height
+                             * GrayscalePlane::bytesPerPixel(format);
+    if (header.width == 0 || header.height == 0 || kHeaderSize + dataBytes > entry->size()) {
+        return false;
+    }
+
+    // Same size and mtime: confirm the content really is unchanged
+    if (hashFileContents(sourcePath) != header.contentHash) {
+        return false;
+    }
+
+    plane = GrayscalePlane::wrap(entry->data() + kHeaderSize,
+                                 static_cast<int>(header.width),
+                                 static_cast<int>(header.height),
+                                 format,
+                                 entry);
+
+    std::cout << "ImageCache: Hit for " << sourcePath << std::endl;
+    return true;
+}
+
+bool ImageCache::store(const std::string& sourcePath, const GrayscalePlane& plane) {
+    if (plane.isEmpty() || static_cast<uint64_t>(plane.getWidth()) * plane.getHeight() < minPixels_) {
+        return false;
+    }
+
+    EntryHeader header = {};
+    std::memcpy(header.magic, kMagic, 4);
+    header.version = kVersion;
+    header.width = static_cast<uint32_t>(plane.getWidth());
+    header.height = static_cast<uint32_t>(plane.getHeight());
+    header.format = static_cast<uint32_t>(plane.getFormat());
+    if (!sourceStat(sourcePath, header.sourceSize, header.sourceMtime)) {
+        return false;
+    }
+    header.contentHash = hashFileContents(sourcePath);
+
+    const std::string canonical = canonicalPath(sourcePath);
+    header.pathHash = hashBytes(canonical.data(), canonical.size());
+
+    std::error_code ec;
+    fs::create_directories(directory_, ec);
+
+    // Write to a temporary file and rename, so readers never see partial entries
+    const std::string finalPath = entryPath(sourcePath);
+    const std::string tempPath = finalPath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "ImageCache: Cannot write " << tempPath << std::endl;
+            return false;
+        }
+
+        char headerBytes[kHeaderSize] = {};
+        std::memcpy(headerBytes, &header, sizeof(header));
+        out.write(headerBytes, kHeaderSize);
+        out.write(static_cast<const char*>(plane.data()), static_cast<std::streamsize>(plane.getSizeBytes()));
+        if (!out) {
+            out.close();
+            fs::remove(tempPath, ec);
+            std::cerr << "ImageCache: Failed to write entry for " << sourcePath << std::endl;
+            return false;
+        }
+    }
+
+    fs::rename(tempPath, finalPath, ec);
+    if (ec) {
+        fs::remove(tempPath, ec);
+        return false;
+    }
+
+    std::cout << "ImageCache: Stored " << sourcePath << " (" << plane.getSizeBytes() << " bytes)" << std::endl;
+    prune();
+    return true;
+}
+
+void ImageCache::prune() const {
+    struct Entry {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type time;
+    };
+
+    std::error_code ec;
+    std::vector<Entry> entries;
+    uint64_t totalBytes = 0;
+    for (const auto& item : fs::directory_iterator(directory_, ec)) {
+        if (item.path().extension() != ".i2sc") {
+            continue;
+        }
+        std::error_code itemEc;
+        const uint64_t size = item.file_size(itemEc);
+        const auto time = item.last_write_time(itemEc);
+        if (!itemEc) {
+            entries.push_back({item.path(), size, time});
+            totalBytes += size;
+        }
+    }
+
+    if (totalBytes <= maxBytes_) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.time < b.time;
+    });
+
+    // Never evict the newest entry, even if it alone exceeds the budget
+    for (size_t i = 0; i + 1 < entries.size() && totalBytes > maxBytes_; ++i) {
+        fs::remove(entries[i].path, ec);
+        if (!ec) {
+            totalBytes -= entries[i].size;
+        }
+    }
+}
+
+} // namespace img2spec
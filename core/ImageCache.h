@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "core/GrayscalePlane.h"
+
+namespace img2spec {
+
+/**
+ * ImageCache: Persistent on-disk cache of decoded grayscale planes
+ * - Keyed by source path, file size, modification time and content hash
+ * - Entries are stored uncompressed and memory-mapped on lookup, so a warm
+ *   load costs one pass over the source file (hash) instead of a decode
+ * - Oldest entries are evicted when the cache exceeds its size budget
+ */
+class ImageCache {
+public:
+    explicit ImageCache(const std::string& directory);
+    ~ImageCache();
+
+    /**
+     * Find a valid entry for the source image
+     * @param plane Receives a plane mapped from the cache file
+     * @return true on cache hit
+     */
+    bool lookup(const std::string& sourcePath, GrayscalePlane& plane) const;
+
+    /**
+     * Store decoded plane for the source image (skipped for small images)
+     * @return true if an entry was written
+     */
+    bool store(const std::string& sourcePath, const GrayscalePlane& plane);
+
+    void setMaxBytes(uint64_t maxBytes) { maxBytes_ = maxBytes; }
+    void setMinPixels(uint64_t minPixels) { minPixels_ = minPixels; }
+
+    const std::string& getDirectory() const { return directory_; }
+
+    /**
+     * 64-bit hash of a whole file's contents (0 if unreadable)
+     */
+    static uint64_t hashFileContents(const std::string& path);
+
+private:
+    std::string entryPath(const std::string& sourcePath) const;
+    void prune() const;
+
+    std::string directory_;
+    uint64_t maxBytes_ = 8ull << 30;  // 8 GB
+    uint64_t minPixels_ = 1ull << 20; // Decoding smaller images is already fast
+};
+
+} // namespace img2spec
@@ -1,4 +1,8 @@
 #include "core/ImageLoader.h"
+#include "core/ImageCache.h"
+#include "core/ImageStripReader.h"
+#include "core/Parallel.h"
+#include "core/RawMatrix.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -9,15 +13,122 @@
 
 namespace img2spec {
 
+namespace {
+
+// Per-axis resampling taps: output i reads index[i * taps + j] with weight[i * taps + j]
+struct AxisWeights {
+    int taps = 0;
+    std::vector<int> index;
+    std::vector<float> weight;
+};
+
+AxisWeights computeAxisWeights(int srcSize, int dstSize, ResampleFilter filter) {
+    AxisWeights axis;
+    const float scale = static_cast<float>(srcSize) / dstSize;
+
+    if (filter == ResampleFilter::AreaAverage && scale > 1.0f) {
+        // Output pixel i covers source interval [i * scale, (i + 1) * scale)
+        axis.taps = static_cast<int>(std::ceil(scale)) + 1;
+        axis.index.assign(static_cast<size_t>(dstSize) * axis.taps, 0);
+        axis.weight.assign(static_cast<size_t>(dstSize) * axis.taps, 0.0f);
+
+        for (int i = 0; i < dstSize; ++i) {
+            const double start = i * static_cast<double>(scale);
+            const double end = std::min((i + 1) * static_cast<double>(scale), static_cast<double>(srcSize));
+            const int first = static_cast<int>(std::floor(start));
+            for (int j = 0; j < axis.taps; ++j) {
+                const int src = first + j;
+                if (src >= srcSize) {
+                    break;
+                }
+                const double overlap = std::min<double>(src + 1, end) - std::max<double>(src, start);
+                if (overlap > 0.0) {
+                    axis.index[static_cast<size_t>(i) * axis.taps + j] = src;
+                    axis.weight[static_cast<size_t>(i) * axis.taps + j] = static_cast<float>(overlap / (end - start));
+                }
+            }
+        }
+        return axis;
+    }
+
+    // Bilinear: sample at i * scale, clamped to the last pixel
+    axis.taps = 2;
+    axis.index.resize(static_cast<size_t>(dstSize) * 2);
+    axis.weight.resize(static_cast<size_t>(dstSize) * 2);
+    for (int i = 0; i < dstSize; ++i) {
+        const float pos = std::max(0.0f, std::min(i * scale, static_cast<float>(srcSize - 1)));
+        const int i0 = static_cast<int>(std::floor(pos));
+        const int i1 = std::min(i0 + 1, srcSize - 1);
+        const float frac = pos - i0;
+        axis.index[i * 2 + 0] = i0;
+        axis.index[i * 2 + 1] = i1;
+        axis.weight[i * 2 + 0] = 1.0f - frac;
+        axis.weight[i * 2 + 1] = frac;
+    }
+    return axis;
+}
+
+} // namespace
+
 ImageLoader::ImageLoader() {}
 
 ImageLoader::~ImageLoader() {}
 
 bool ImageLoader::load(const std::string& path) {
+    // Raw float32 intensity matrices (.npy / I2SF): map in place, no decode
+    if (RawMatrix::isRawMatrixFile(path)) {
+        RawMatrix matrix;
+        if (!matrix.open(path)) {
+            return false;
+        }
+        if (matrix.getContent() != MatrixContent::Intensity) {
+            std::cerr << "ImageLoader: " << path << " holds STFT magnitudes, not an image;"
+                      << " pass RawMatrix::data() to GriffinLim::reconstruct instead" << std::endl;
+            return false;
+        }
+        plane_ = matrix.asPlane();
+        decodeMode_ = DecodeMode::Mapped;
+        return true;
+    }
+
+    // Previously decoded: map the cached plane instead of decoding again
+    if (cache_ && cache_->lookup(path, plane_)) {
+        std::cout << "ImageLoader: Loaded image " << path << " from cache" << std::endl;
+        std::cout << "  Size: " << plane_.getWidth() << "x" << plane_.getHeight() << std::endl;
+        decodeMode_ = DecodeMode::Cached;
+        return true;
+    }
+
+    if (!decode(path)) {
+        return false;
+    }
+
+    if (cache_) {
+        cache_->store(path, plane_);
+    }
+    return true;
+}
+
+bool ImageLoader::decode(const std::string& path) {
+    // PGM/PPM and PNG: decode row by row, never holding the interleaved RGB buffer
+    ImageStripReader stripReader;
+    if (stripReader.openStreaming(path)) {
+        if (!loadStrips(stripReader)) {
+            return false;
+        }
+        decodeMode_ = DecodeMode::Strips;
+        return true;
+    }
+
+    int width = 0;
+    int height = 0;
     int channels = 0;
 
-    // Load image with stb_image
-    unsigned char* data = stbi_load(path.c_str(), &width_, &height_, &channels, 0);
+    // Load image with stb_image, keeping 16-bit sources at full precision
+    const bool is16Bit = stbi_is_16_bit(path.c_str()) != 0;
+    void* data = is16Bit
+        ? static_cast<void*>(stbi_load_16(path.c_str(), &width, &height, &channels, 0))
+        : static_cast<void*>(stbi_load(path.c_str(), &width, &height, &channels, 0));
 
     if (!data) {
         std::cerr << "ImageLoader: Failed to load image: " << path << std::endl;
@@ -26,95 +137,119 @@ bool ImageLoader::load(const std::string& path) {
     }
 
     std::cout << "ImageLoader: Loaded image " << path << std::endl;
-    std::cout << "  Size: " << width_ << "x" << height_ << std::endl;
-    std::cout << "  Channels: " << channels << std::endl;
+    std::cout << "  Size: " << width << "x" << height << std::endl;
+    std::cout << "  Channels: " << channels << (is16Bit ? " (16 bit)" : " (8 bit)") << std::endl;
+    std::cout << "  Decoded in full (" << static_cast<size_t>(width) * height * channels * (is16Bit ? 2 : 1)
+              << " bytes interleaved); only PGM/PPM"
+              << (ImageStripReader::canStreamPng() ? " and non-interlaced PNG" : "")
+              << " are decoded in strips" << std::endl;
 
     // Convert to grayscale
-    convertToGrayscale(data, channels);
+    const size_t numPixels = static_cast<size_t>(width) * height;
+    if (is16Bit) {
+        plane_ = GrayscalePlane::allocate(width, height, PixelFormat::UInt16);
+        convertToGrayscale(static_cast<const uint16_t*>(data), channels, numPixels,
+                           static_cast<uint16_t*>(plane_.mutableData()));
+    } else {
+        plane_ = GrayscalePlane::allocate(width, height, PixelFormat::UInt8);
+        convertToGrayscale(static_cast<const uint8_t*>(data), channels, numPixels,
+                           static_cast<uint8_t*>(plane_.mutableData()));
+    }
 
     // Free stb_image data
     stbi_image_free(data);
+    decodeMode_ = DecodeMode::FullBuffer;
 
-    std::cout << "  Converted to grayscale: " << grayscaleData_.size() << " pixels" << std::endl;
+    std::cout << "  Converted to grayscale: " << numPixels << " pixels" << std::endl;
 
     return true;
 }
 
-void ImageLoader::convertToGrayscale(const unsigned char* data, int channels) {
-    const int numPixels = width_ * height_;
-    grayscaleData_.resize(numPixels);
-
-    for (int i = 0; i < numPixels; ++i) {
-        const int idx = i * channels;
-
-        if (channels == 1) {
-            // Already grayscale
-            grayscaleData_[i] = data[idx] / 255.0f;
-        } else if (channels == 2) {
-            // Grayscale + Alpha (ignore alpha)
-            grayscaleData_[i] = data[idx] / 255.0f;
-        } else if (channels >= 3) {
-            // RGB or RGBA (ignore alpha if present)
-            const float r = data[idx + 0] / 255.0f;
-            const float g = data[idx + 1] / 255.0f;
-            const float b = data[idx + 2] / 255.0f;
-
-            // ITU-R BT.709 luminance formula
-            const float luminance = 0.2126f * r + 0.7152f * g + 0.0722f * b;
-            grayscaleData_[i] = luminance;
-        }
-    }
-}
+bool ImageLoader::loadStrips(ImageStripReader& reader) {
+    GrayscalePlane plane = GrayscalePlane::allocate(
+        reader.getWidth(), reader.getHeight(), reader.getPixelFormat());
 
-float ImageLoader::getPixel(int x, int y) const {
-    if (x < 0 || x >= width_ || y < 0 || y >= height_) {
-        return 0.0f;
+    constexpr int kStripRows = 64;
+    for (int y0 = 0; y0 < plane.getHeight(); y0 += kStripRows) {
+        const int y1 = std::min(y0 + kStripRows, plane.getHeight());
+        if (!reader.readRows(y0, y1, plane)) {
+            plane_ = GrayscalePlane();
+            return false;
+        }
     }
-    return grayscaleData_[y * width_ + x];
-}
 
-float ImageLoader::bilinearSample(float x, float y) const {
-    // Clamp to valid range
-    x = std::max(0.0f, std::min(x, static_cast<float>(width_ - 1)));
-    y = std::max(0.0f, std::min(y, static_cast<float>(height_ - 1)));
+    plane_ = plane;
+    std::cout << "  Converted to grayscale: " << static_cast<size_t>(plane_.getWidth()) * plane_.getHeight()
+              << " pixels" << std::endl;
 
-    const int x0 = static_cast<int>(std::floor(x));
-    const int y0 = static_cast<int>(std::floor(y));
-    const int x1 = std::min(x0 + 1, width_ - 1);
-    const int y1 = std::min(y0 + 1, height_ - 1);
-
-    const float fx = x - x0;
-    const float fy = y - y0;
-
-    const float v00 = getPixel(x0, y0);
-    const float v10 = getPixel(x1, y0);
-    const float v01 = getPixel(x0, y1);
-    const float v11 = getPixel(x1, y1);
-
-    const float v0 = v00 * (1.0f - fx) + v10 * fx;
-    const float v1 = v01 * (1.0f - fx) + v11 * fx;
+    return true;
+}
 
-    return v0 * (1.0f - fy) + v1 * fy;
+std::vector<float> ImageLoader::resample(int newWidth, int newHeight, ResampleFilter filter) const {
+    return resample(plane_, newWidth, newHeight, filter);
 }
 
-std::vector<float> ImageLoader::resample(int newWidth, int newHeight) const {
-    if (!isLoaded()) {
+std::vector<float> ImageLoader::resample(const GrayscalePlane& plane, int newWidth, int newHeight,
+                                         ResampleFilter filter) {
+    if (plane.isEmpty() || newWidth <= 0 || newHeight <= 0) {
         return {};
     }
 
-    std::vector<float> resampled(newWidth * newHeight);
+    const int width = plane.getWidth();
+    const int height = plane.getHeight();
+    const AxisWeights xWeights = computeAxisWeights(width, newWidth, filter);
+    const AxisWeights yWeights = computeAxisWeights(height, newHeight, filter);
 
-    const float xScale = static_cast<float>(width_) / newWidth;
-    const float yScale = static_cast<float>(height_) / newHeight;
-
-    for (int y = 0; y < newHeight; ++y) {
-        for (int x = 0; x < newWidth; ++x) {
-            const float srcX = x * xScale;
-            const float srcY = y * yScale;
-            resampled[y * newWidth + x] = bilinearSample(srcX, srcY);
+    // Only source rows referenced by the vertical pass need horizontal filtering
+    std::vector<char> rowUsed(height, 0);
+    for (size_t i = 0; i < yWeights.index.size(); ++i) {
+        if (yWeights.weight[i] != 0.0f) {
+            rowUsed[yWeights.index[i]] = 1;
         }
     }
 
+    // Pass 1: horizontal, source rows -> newWidth columns
+    std::vector<float> horizontal(static_cast<size_t>(newWidth) * height);
+    parallelFor(0, height, [&](int y0, int y1) {
+        std::vector<float> srcRow(width);
+        for (int y = y0; y < y1; ++y) {
+            if (!rowUsed[y]) {
+                continue;
+            }
+            plane.readRow(y, 0, width, srcRow.data());
+            float* dst = horizontal.data() + static_cast<size_t>(y) * newWidth;
+            for (int x = 0; x < newWidth; ++x) {
+                const int* idx = &xWeights.index[static_cast<size_t>(x) * xWeights.taps];
+                const float* w = &xWeights.weight[static_cast<size_t>(x) * xWeights.taps];
+                float sum = 0.0f;
+                for (int j = 0; j < xWeights.taps; ++j) {
+                    sum += srcRow[idx[j]] * w[j];
+                }
+                dst[x] = sum;
+            }
+        }
+    }, 16);
+
+    // Pass 2: vertical, whole rows at a time so the inner loop is contiguous
+    std::vector<float> resampled(static_cast<size_t>(newWidth) * newHeight);
+    parallelFor(0, newHeight, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            float* dst = resampled.data() + static_cast<size_t>(y) * newWidth;
+            std::fill(dst, dst + newWidth, 0.0f);
+            for (int j = 0; j < yWeights.taps; ++j) {
+                const size_t tap = static_cast<size_t>(y) * yWeights.taps + j;
+                const float w = yWeights.weight[tap];
+                if (w == 0.0f) {
+                    continue;
+                }
+                const float* src = horizontal.data() + static_cast<size_t>(yWeights.index[tap]) * newWidth;
+                for (int x = 0; x < newWidth; ++x) {
+                    dst[x] += src[x] * w;
+                }
+            }
+        }
+    }, 16);
+
     return resampled;
 }
 
@@ -4,14 +4,40 @@
 #include <string>
 #include <memory>
 
+#include "core/GrayscalePlane.h"
+
 namespace img2spec {
 
+class ImageCache;
+class ImageStripReader;
+
+// How load() obtained the grayscale plane
+enum class DecodeMode {
+    None,       // nothing loaded
+    Mapped,     // float32 matrix mapped in place
+    Cached,     // plane mapped from the decoded-image cache
+    Strips,     // decoded row by row (PGM/PPM, non-interlaced PNG with libpng)
+    FullBuffer  // stb_image decoded the whole interleaved RGB(A) buffer first
+                // (JPG, interlaced PNG, PNG without libpng)
+};
+
+enum class ResampleFilter {
+    Bilinear,   // Interpolate between the two nearest pixels
+    AreaAverage // Average all covered pixels (downscaling; bilinear when upscaling)
+};
+
 /**
  * ImageLoader: Loads PNG/JPG images and converts to grayscale
  * - Handles RGBA/RGB images
  * - Converts to grayscale using luminance formula
  * - Ignores alpha channel
+ * - Keeps grayscale as 8-bit (16-bit for 16-bit sources)
  * - Supports bilinear resampling
+ * - PGM/PPM and (with libpng) non-interlaced PNG are decoded in strips (see
+ *   ImageStripReader); other formats peak at the full interleaved buffer,
+ *   reported by getDecodeMode()
+ * - Float32 .npy / I2SF intensity matrices are memory-mapped (see RawMatrix)
+ * - Optional persistent cache of decoded planes (see ImageCache)
  */
 class ImageLoader {
 public:
@@ -20,30 +46,44 @@ public:
 
     /**
      * Load image from file path
-     * @param path File path to PNG or JPG
+     * @param path File path to PNG, JPG, PGM, PPM, NPY or F32
      * @return true if successful
      */
     bool load(const std::string& path);
 
     /**
-     * Get grayscale data (normalized to [0.0, 1.0])
-     * @return Pointer to grayscale data (row-major, top to bottom)
+     * Use a persistent cache of decoded planes (nullptr disables caching)
      */
-    const std::vector<float>& getGrayscaleData() const { return grayscaleData_; }
+    void setCache(std::shared_ptr<ImageCache> cache) { cache_ = std::move(cache); }
+
+    /**
+     * Get grayscale plane (row-major, top to bottom)
+     * @return Compact grayscale pixels; see GrayscalePlane for access
+     */
+    const GrayscalePlane& getPlane() const { return plane_; }
 
     /**
      * Get image dimensions
      */
-    int getWidth() const { return width_; }
-    int getHeight() const { return height_; }
+    int getWidth() const { return plane_.getWidth(); }
+    int getHeight() const { return plane_.getHeight(); }
 
     /**
-     * Resample image to new dimensions using bilinear interpolation
+     * Resample image to new dimensions
+     * - Separable: horizontal pass, then vertical pass, rows in parallel
      * @param newWidth Target width
      * @param newHeight Target height
-     * @return Resampled grayscale data
+     * @param filter Bilinear (default) or area averaging
+     * @return Resampled grayscale data (row-major, normalized [0.0, 1.0])
+     */
+    std::vector<float> resample(int newWidth, int newHeight,
+                                ResampleFilter filter = ResampleFilter::Bilinear) const;
+
+    /**
+     * Resample any grayscale plane (see resample above)
      */
-    std::vector<float> resample(int newWidth, int newHeight) const;
+    static std::vector<float> resample(const GrayscalePlane& plane, int newWidth, int newHeight,
+                                       ResampleFilter filter = ResampleFilter::Bilinear);
 
     /**
      * Get grayscale value at position (with bounds checking)
@@ -51,20 +91,27 @@ public:
      * @param y Vertical position (0..height-1)
      * @return Grayscale value [0.0, 1.0]
      */
-    float getPixel(int x, int y) const;
+    float getPixel(int x, int y) const { return plane_.getPixel(x, y); }
 
     /**
      * Check if image is loaded
      */
-    bool isLoaded() const { return !grayscaleData_.empty(); }
+    bool isLoaded() const { return !plane_.isEmpty(); }
+
+    /**
+     * How the last successful load() decoded the image. FullBuffer means
+     * peak memory was width x height x channels (x2 for 16 bit) on top of
+     * the plane.
+     */
+    DecodeMode getDecodeMode() const { return decodeMode_; }
 
 private:
-    void convertToGrayscale(const unsigned char* data, int channels);
-    float bilinearSample(float x, float y) const;
+    bool decode(const std::string& path);
+    bool loadStrips(ImageStripReader& reader);
 
-    int width_ = 0;
-    int height_ = 0;
-    std::vector<float> grayscaleData_; // Normalized [0.0, 1.0]
+    GrayscalePlane plane_;
+    DecodeMode decodeMode_ = DecodeMode::None;
+    std::shared_ptr<ImageCache> cache_;
 };
 
 } // namespace img2spec
@@ -0,0 +1,460 @@
+#include "core/ImageStripReader.h"
+#include "core/ImageLoader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <csetjmp>
+#include <cstring>
+#include <iostream>
+
+#ifdef IMG2SPEC_HAVE_LIBPNG
+#include <png.h>
+#endif
+
+namespace img2spec {
+
+namespace {
+
+bool seekTo(std::FILE* file, int64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+int64_t tellPosition(std::FILE* file) {
+#ifdef _WIN32
+    return _ftelli64(file);
+#else
+    return static_cast<int64_t>(ftello(file));
+#endif
+}
+
+// Read next unsigned integer from a PNM header, skipping whitespace and comments
+bool readHeaderInt(std::FILE* file, int& value) {
+    int c = std::fgetc(file);
+    while (c != EOF) {
+        if (c == '#') {
+            while (c != EOF && c != '\n' && c != '\r') {
+                c = std::fgetc(file);
+            }
+        } else if (std::isspace(c)) {
+            c = std::fgetc(file);
+        } else {
+            break;
+        }
+    }
+
+    if (c == EOF || !std::isdigit(c)) {
+        return false;
+    }
+
+    int64_t result = 0;
+    while (c != EOF && std::isdigit(c)) {
+        result = result * 10 + (c - '0');
+        if (result > 0x7fffffff) {
+            return false;
+        }
+        c = std::fgetc(file);
+    }
+
+    // Exactly one whitespace character follows the last header field
+    if (c != EOF && !std::isspace(c)) {
+        return false;
+    }
+
+    value = static_cast<int>(result);
+    return true;
+}
+
+#ifdef IMG2SPEC_HAVE_LIBPNG
+// libpng reports errors with longjmp. The helpers below call it with only
+// trivially destructible locals between setjmp and the libpng calls.
+void pngError(png_structp png, png_const_charp message) {
+    std::cerr << "ImageStripReader: libpng: " << message << std::endl;
+    png_longjmp(png, 1);
+}
+
+void pngWarning(png_structp, png_const_charp) {}
+
+// Read the header and set up transforms to 1 or 3 channels of 8 or 16 bit
+// (native byte order), alpha stripped as in the stb_image path
+bool pngReadHeader(png_structp png, png_infop info, std::FILE* file, bool* interlaced) {
+    if (setjmp(png_jmpbuf(png))) {
+        return false;
+    }
+    png_init_io(png, file);
+    png_set_sig_bytes(png, 8);
+    // Default limits reject images over a million pixels wide
+    png_set_user_limits(png, 0x7fffffff, 0x7fffffff);
+    png_read_info(png, info);
+
+    *interlaced = png_get_interlace_type(png, info) != PNG_INTERLACE_NONE;
+    const int colorType = png_get_color_type(png, info);
+    const int bitDepth = png_get_bit_depth(png, info);
+    if (colorType == PNG_COLOR_TYPE_PALETTE) {
+        png_set_palette_to_rgb(png);
+    }
+    if (colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8) {
+        png_set_expand_gray_1_2_4_to_8(png);
+    }
+    if (colorType & PNG_COLOR_MASK_ALPHA) {
+        png_set_strip_alpha(png);
+    }
+    const uint16_t one = 1;
+    if (bitDepth == 16 && *reinterpret_cast<const unsigned char*>(&one) == 1) {
+        png_set_swap(png); // PNG stores 16-bit samples big-endian
+    }
+    png_read_update_info(png, info);
+    return true;
+}
+
+bool pngReadRow(png_structp png, unsigned char* row) {
+    if (setjmp(png_jmpbuf(png))) {
+        return false;
+    }
+    png_read_row(png, row, nullptr);
+    return true;
+}
+#endif
+
+} // namespace
+
+#ifdef IMG2SPEC_HAVE_LIBPNG
+struct ImageStripReader::PngDecoder {
+    png_structp png = nullptr;
+    png_infop info = nullptr;
+    int nextRow = 0;     // next row libpng produces
+    int currentRow = -1; // row held in row
+    std::vector<unsigned char> row;
+
+    ~PngDecoder() {
+        if (png) {
+            png_destroy_read_struct(&png, info ? &info : nullptr, nullptr);
+        }
+    }
+};
+#else
+struct ImageStripReader::PngDecoder {};
+#endif
+
+bool ImageStripReader::canStreamPng() {
+#ifdef IMG2SPEC_HAVE_LIBPNG
+    return true;
+#else
+    return false;
+#endif
+}
+
+ImageStripReader::ImageStripReader() {}
+
+ImageStripReader::~ImageStripReader() {
+    close();
+}
+
+void ImageStripReader::close() {
+    png_.reset();
+    isPng_ = false;
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    width_ = 0;
+    height_ = 0;
+    channels_ = 0;
+    dataOffset_ = 0;
+    spanBuffer_.clear();
+    sampleBuffer_.clear();
+    grayBuffer_.clear();
+    plane_ = GrayscalePlane();
+}
+
+bool ImageStripReader::openStreaming(const std::string& path) {
+    close();
+
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    char magic[2] = {0, 0};
+    if (std::fread(magic, 1, 2, file) != 2) {
+        std::fclose(file);
+        return false;
+    }
+
+    if (static_cast<unsigned char>(magic[0]) == 0x89 && magic[1] == 'P') {
+        file_ = file;
+        isPng_ = true;
+        if (!startPng()) {
+            close();
+            return false;
+        }
+        std::cout << "ImageStripReader: Streaming " << path << " (PNG rows)" << std::endl;
+        std::cout << "  Size: " << width_ << "x" << height_ << std::endl;
+        std::cout << "  Channels: " << channels_ << (format_ == PixelFormat::UInt16 ? " (16 bit)" : " (8 bit)")
+                  << std::endl;
+        return true;
+    }
+
+    if (magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6')) {
+        std::fclose(file);
+        return false;
+    }
+
+    int width = 0;
+    int height = 0;
+    int maxValue = 0;
+    if (!readHeaderInt(file, width) || !readHeaderInt(file, height) || !readHeaderInt(file, maxValue)
+        || width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 65535) {
+        std::cerr << "ImageStripReader: Invalid PNM header: " << path << std::endl;
+        std::fclose(file);
+        return false;
+    }
+
+    file_ = file;
+    width_ = width;
+    height_ = height;
+    channels_ = (magic[1] == '6') ? 3 : 1;
+    maxValue_ = maxValue;
+    format_ = (maxValue > 255) ? PixelFormat::UInt16 : PixelFormat::UInt8;
+    dataOffset_ = tellPosition(file);
+
+    std::cout << "ImageStripReader: Streaming " << path << std::endl;
+    std::cout << "  Size: " << width_ << "x" << height_ << std::endl;
+    std::cout << "  Channels: " << channels_ << ", max value " << maxValue_ << std::endl;
+
+    return true;
+}
+
+bool ImageStripReader::startPng() {
+#ifdef IMG2SPEC_HAVE_LIBPNG
+    png_.reset();
+    unsigned char signature[8];
+    if (!seekTo(file_, 0) || std::fread(signature, 1, 8, file_) != 8 || png_sig_cmp(signature, 0, 8) != 0) {
+        return false;
+    }
+
+    auto decoder = std::make_unique<PngDecoder>();
+    decoder->png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, pngError, pngWarning);
+    if (!decoder->png) {
+        return false;
+    }
+    decoder->info = png_create_info_struct(decoder->png);
+    if (!decoder->info) {
+        return false;
+    }
+
+    bool interlaced = false;
+    if (!pngReadHeader(decoder->png, decoder->info, file_, &interlaced)) {
+        return false;
+    }
+    if (interlaced) {
+        // Adam7 rows are only complete after the last pass
+        std::cout << "ImageStripReader: Interlaced PNG cannot be decoded row by row" << std::endl;
+        return false;
+    }
+
+    const int channels = png_get_channels(decoder->png, decoder->info);
+    const int bitDepth = png_get_bit_depth(decoder->png, decoder->info);
+    if ((channels != 1 && channels != 3) || (bitDepth != 8 && bitDepth != 16)) {
+        return false;
+    }
+    decoder->row.resize(png_get_rowbytes(decoder->png, decoder->info));
+
+    width_ = static_cast<int>(png_get_image_width(decoder->png, decoder->info));
+    height_ = static_cast<int>(png_get_image_height(decoder->png, decoder->info));
+    channels_ = channels;
+    format_ = (bitDepth == 16) ? PixelFormat::UInt16 : PixelFormat::UInt8;
+    maxValue_ = (bitDepth == 16) ? 65535 : 255;
+    png_ = std::move(decoder);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ImageStripReader::readPngRow(int y) {
+#ifdef IMG2SPEC_HAVE_LIBPNG
+    if (y == png_->currentRow) {
+        return true;
+    }
+    // Rows come in order only: an earlier row restarts the decode
+    if (y < png_->nextRow && !startPng()) {
+        return false;
+    }
+    while (png_->nextRow <= y) {
+        if (!pngReadRow(png_->png, png_->row.data())) {
+            std::cerr << "ImageStripReader: Failed to decode PNG row " << png_->nextRow << std::endl;
+            // libpng state is undefined after the longjmp; later reads fail
+            png_.reset();
+            return false;
+        }
+        ++png_->nextRow;
+    }
+    png_->currentRow = y;
+    return true;
+#else
+    (void)y;
+    return false;
+#endif
+}
+
+bool ImageStripReader::open(const std::string& path) {
+    if (openStreaming(path)) {
+        return true;
+    }
+
+    // Fallback: full decode, keep only the compact grayscale plane
+    ImageLoader loader;
+    if (!loader.load(path)) {
+        return false;
+    }
+
+    plane_ = loader.getPlane();
+    width_ = plane_.getWidth();
+    height_ = plane_.getHeight();
+    format_ = plane_.getFormat();
+    return true;
+}
+
+bool ImageStripReader::readSpanCompact(int y, int x0, int x1, void* out) {
+    const int count = x1 - x0;
+
+    if (!file_) {
+        const size_t bpp = plane_.getBytesPerPixel();
+        const auto* row = static_cast<const unsigned char*>(plane_.data()) + static_cast<size_t>(y) * width_ * bpp;
+        std::memcpy(out, row + x0 * bpp, count * bpp);
+        return true;
+    }
+
+    const int bytesPerSample = (format_ == PixelFormat::UInt16) ? 2 : 1;
+    const int64_t pixelBytes = static_cast<int64_t>(channels_) * bytesPerSample;
+
+    if (isPng_) {
+#ifdef IMG2SPEC_HAVE_LIBPNG
+        if (png_ && readPngRow(y)) {
+            // Full-range samples in native byte order, no rescaling
+            const unsigned char* pixels = png_->row.data() + x0 * pixelBytes;
+            if (format_ == PixelFormat::UInt8) {
+                convertToGrayscale(pixels, channels_, count, static_cast<uint8_t*>(out));
+            } else {
+                convertToGrayscale(reinterpret_cast<const uint16_t*>(pixels), channels_, count,
+                                   static_cast<uint16_t*>(out));
+            }
+            return true;
+        }
+#endif
+        // No decoder after a failed decode or restart; the file is not PNM data
+        return false;
+    }
+
+    const int64_t offset = dataOffset_ + (static_cast<int64_t>(y) * width_ + x0) * pixelBytes;
+    const size_t spanBytes = static_cast<size_t>(count) * pixelBytes;
+
+    spanBuffer_.resize(spanBytes);
+    if (!seekTo(file_, offset) || std::fread(spanBuffer_.data(), 1, spanBytes, file_) != spanBytes) {
+        std::cerr << "ImageStripReader: Unexpected end of image data at row " << y << std::endl;
+        return false;
+    }
+
+    if (format_ == PixelFormat::UInt8) {
+        auto* dst = static_cast<uint8_t*>(out);
+        convertToGrayscale(spanBuffer_.data(), channels_, count, dst);
+        if (maxValue_ != 255) {
+            for (int x = 0; x < count; ++x) {
+                dst[x] = static_cast<uint8_t>(std::min(255, (dst[x] * 255 + maxValue_ / 2) / maxValue_));
+            }
+        }
+        return true;
+    }
+
+    // PNM stores 16-bit samples big-endian
+    const size_t numSamples = static_cast<size_t>(count) * channels_;
+    sampleBuffer_.resize(numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+        sampleBuffer_[i] = static_cast<uint16_t>((spanBuffer_[i * 2] << 8) | spanBuffer_[i * 2 + 1]);
+    }
+
+    auto* dst = static_cast<uint16_t*>(out);
+    convertToGrayscale(sampleBuffer_.data(), channels_, count, dst);
+    if (maxValue_ != 65535) {
+        for (int x = 0; x < count; ++x) {
+            const uint32_t scaled = (static_cast<uint32_t>(dst[x]) * 65535u + maxValue_ / 2) / maxValue_;
+            dst[x] = static_cast<uint16_t>(std::min<uint32_t>(65535u, scaled));
+        }
+    }
+    return true;
+}
+
+bool ImageStripReader::readSpan(int y, int x0, int x1, float* out) {
+    if (!file_) {
+        plane_.readRow(y, x0, x1, out);
+        return true;
+    }
+
+    const int count = x1 - x0;
+    grayBuffer_.resize(count);
+    if (!readSpanCompact(y, x0, x1, grayBuffer_.data())) {
+        return false;
+    }
+
+    const float scale = GrayscalePlane::normalizationScale(format_);
+    if (format_ == PixelFormat::UInt8) {
+        const auto* gray = reinterpret_cast<const uint8_t*>(grayBuffer_.data());
+        for (int x = 0; x < count; ++x) {
+            out[x] = gray[x] * scale;
+        }
+    } else {
+        for (int x = 0; x < count; ++x) {
+            out[x] = grayBuffer_[x] * scale;
+        }
+    }
+    return true;
+}
+
+bool ImageStripReader::readRows(int y0, int y1, float* out) {
+    if (!isOpen() || y0 < 0 || y1 > height_ || y0 >= y1) {
+        return false;
+    }
+
+    for (int y = y0; y < y1; ++y) {
+        if (!readSpan(y, 0, width_, out + static_cast<size_t>(y - y0) * width_)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ImageStripReader::readRows(int y0, int y1, GrayscalePlane& plane) {
+    if (!isOpen() || y0 < 0 || y1 > height_ || y0 >= y1 || !plane.mutableData()
+        || plane.getWidth() != width_ || plane.getHeight() != height_ || plane.getFormat() != format_) {
+        return false;
+    }
+
+    const size_t rowBytes = static_cast<size_t>(width_) * plane.getBytesPerPixel();
+    auto* base = static_cast<unsigned char*>(plane.mutableData());
+    for (int y = y0; y < y1; ++y) {
+        if (!readSpanCompact(y, 0, width_, base + static_cast<size_t>(y) * rowBytes)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ImageStripReader::readColumns(int x0, int x1, float* out) {
+    if (!isOpen() || x0 < 0 || x1 > width_ || x0 >= x1) {
+        return false;
+    }
+
+    const int stripWidth = x1 - x0;
+    for (int y = 0; y < height_; ++y) {
+        if (!readSpan(y, x0, x1, out + static_cast<size_t>(y) * stripWidth)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace img2spec
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/GrayscalePlane.h"
+
+namespace img2spec {
+
+/**
+ * ImageStripReader: Strip-oriented grayscale access for very large images
+ * - Binary PGM/PPM (P5/P6, 8 or 16 bit) are decoded incrementally: only the
+ *   requested rows are read from disk and converted to grayscale
+ * - Non-interlaced PNG is decoded row by row with libpng when the build has
+ *   it (IMG2SPEC_HAVE_LIBPNG). Rows come in order; reading an earlier row
+ *   restarts the decode, so readColumns() decodes the file once per call
+ * - Other formats (JPG, interlaced PNG) cannot be decoded incrementally by
+ *   stb_image; they are decoded once, converted, and the RGB(A) buffer is
+ *   released
+ * - Strips are returned as normalized float or in compact 8/16-bit form
+ */
+class ImageStripReader {
+public:
+    ImageStripReader();
+    ~ImageStripReader();
+
+    ImageStripReader(const ImageStripReader&) = delete;
+    ImageStripReader& operator=(const ImageStripReader&) = delete;
+
+    /**
+     * Open image for strip access (streaming when the format allows it)
+     * @param path File path
+     * @return true if successful
+     */
+    bool open(const std::string& path);
+
+    /**
+     * Open image only if it can be decoded incrementally (PGM/PPM, PNG)
+     * @return false for other formats, without decoding anything
+     */
+    bool openStreaming(const std::string& path);
+
+    void close();
+
+    bool isOpen() const { return width_ > 0 && height_ > 0; }
+    bool isStreaming() const { return file_ != nullptr; }
+
+    /**
+     * Whether this build decodes PNG incrementally (linked against libpng)
+     */
+    static bool canStreamPng();
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+
+    /**
+     * Compact format of the source samples (UInt8 or UInt16)
+     */
+    PixelFormat getPixelFormat() const { return format_; }
+
+    /**
+     * Read horizontal strip (rows [y0, y1))
+     * @param out Row-major output, width x (y1 - y0)
+     */
+    bool readRows(int y0, int y1, float* out);
+
+    /**
+     * Read rows [y0, y1) into the same rows of a compact plane
+     * @param plane Owned plane with matching size and getPixelFormat()
+     */
+    bool readRows(int y0, int y1, GrayscalePlane& plane);
+
+    /**
+     * Read vertical strip (columns [x0, x1) of every row)
+     * @param out Row-major output, (x1 - x0) x height
+     */
+    bool readColumns(int x0, int x1, float* out);
+
+private:
+    struct PngDecoder;
+
+    bool startPng();
+    bool readPngRow(int y);
+    bool readSpanCompact(int y, int x0, int x1, void* out);
+    bool readSpan(int y, int x0, int x1, float* out);
+
+    int width_ = 0;
+    int height_ = 0;
+
+    // Streaming (PNM, PNG) state
+    std::FILE* file_ = nullptr;
+    std::unique_ptr<PngDecoder> png_; // PNG only: libpng state and the last decoded row
+    bool isPng_ = false;              // PNG source, even once a failed decode dropped png_
+    int64_t dataOffset_ = 0;
+    int channels_ = 0;
+    int maxValue_ = 255;
+    PixelFormat format_ = PixelFormat::UInt8;
+    std::vector<unsigned char> spanBuffer_;
+    std::vector<uint16_t> sampleBuffer_;
+    std::vector<uint16_t> grayBuffer_;
+
+    // Fallback: fully decoded grayscale plane
+    GrayscalePlane plane_;
+};
+
+} // namespace img2spec
@@ -1,6 +1,9 @@
 #include "core/Leveling.h"
+#include "core/Parallel.h"
 #include <cmath>
 #include <algorithm>
+#include <limits>
+#include <mutex>
 #include <numeric>
 
 namespace img2spec {
@@ -83,4 +86,500 @@ std::vector<float> Leveling::monoToStereo(const std::vector<float>& mono) {
     return stereo;
 }
 
+namespace {
+
+// Neumaier summation step: keeps the rounding error of sum += value
+inline void compensatedAdd(double& sum, double& compensation, double value) {
+    const double t = sum + value;
+    if (std::abs(sum) >= std::abs(value)) {
+        compensation += (sum - t) + value;
+    } else {
+        compensation += (value - t) + sum;
+    }
+    sum = t;
+}
+
+constexpr int kMinParallelSamples = 1 << 16;
+
+// Zeroth-order modified Bessel function (power series)
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    const double halfX = x * 0.5;
+    for (int k = 1; k < 32; ++k) {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+    }
+    return sum;
+}
+
+} // namespace
+
+TruePeakMeter::TruePeakMeter() {
+    // Kaiser-windowed sinc interpolator, cutoff at the input Nyquist frequency
+    constexpr int kTaps = kOversampling * kTapsPerPhase;
+    constexpr double kBeta = 6.0;
+    const double center = (kTaps - 1) * 0.5;
+    const double pi = 3.14159265358979323846;
+
+    std::array<double, kTaps> prototype;
+    for (int n = 0; n < kTaps; ++n) {
+        const double t = (n - center) / kOversampling;
+        const double sinc = (std::abs(t) < 1e-12) ? 1.0 : std::sin(pi * t) / (pi * t);
+        const double r = (n - center) / center;
+        prototype[n] = sinc * besselI0(kBeta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(kBeta);
+    }
+
+    // Split into phases with unity DC gain each, so that the oversampled
+    // extremes of (x - mean) are the extremes of x shifted by mean
+    for (int p = 0; p < kOversampling; ++p) {
+        double sum = 0.0;
+        for (int j = 0; j < kTapsPerPhase; ++j) {
+            sum += prototype[p + j * kOversampling];
+        }
+        for (int j = 0; j < kTapsPerPhase; ++j) {
+            phases_[p][kTapsPerPhase - 1 - j] = static_cast<float>(prototype[p + j * kOversampling] / sum);
+        }
+    }
+
+    reset();
+}
+
+void TruePeakMeter::reset() {
+    buffer_.assign(kTapsPerPhase - 1, 0.0f);
+    started_ = false;
+    // Like PostProcessor::analyze(): no extreme before the first sample
+    min_ = std::numeric_limits<float>::infinity();
+    max_ = -std::numeric_limits<float>::infinity();
+}
+
+void TruePeakMeter::process(const float* audio, size_t numSamples) {
+    run<false>(audio, numSamples, nullptr);
+}
+
+void TruePeakMeter::processPeaks(const float* audio, size_t numSamples, float* peaks) {
+    run<true>(audio, numSamples, peaks);
+}
+
+template <bool WritePeaks>
+void TruePeakMeter::run(const float* audio, size_t numSamples, float* peaks) {
+    constexpr size_t kHistory = kTapsPerPhase - 1;
+    constexpr size_t kBlock = 256;
+    if (numSamples == 0) {
+        return;
+    }
+
+    // Samples before the first are taken as equal to it: zeros would add
+    // an interpolated extreme near 0 to a signal that never gets there
+    if (!started_) {
+        std::fill(buffer_.begin(), buffer_.end(), audio[0]);
+        started_ = true;
+    }
+
+    buffer_.resize(kHistory + numSamples);
+    std::copy(audio, audio + numSamples, buffer_.begin() + kHistory);
+    const float* buf = buffer_.data();
+
+    // Vectorized across output samples: per block and phase, each tap adds
+    // the input shifted by one sample into the block's accumulators.
+    // Extremes are kept per block position and reduced once per call.
+    float acc[kBlock];
+    float sampleLo[kBlock];
+    float sampleHi[kBlock];
+    float runLo[kBlock];
+    float runHi[kBlock];
+    std::fill(runLo, runLo + kBlock, min_);
+    std::fill(runHi, runHi + kBlock, max_);
+
+    for (size_t start = 0; start < numSamples; start += kBlock) {
+        const size_t n = std::min(kBlock, numSamples - start);
+        const float* window = buf + start;
+        for (size_t i = 0; i < n; ++i) {
+            sampleLo[i] = window[kHistory + i];
+            sampleHi[i] = window[kHistory + i];
+        }
+        for (int p = 0; p < kOversampling; ++p) {
+            const float* taps = phases_[p].data();
+            for (size_t i = 0; i < n; ++i) {
+                acc[i] = taps[0] * window[i];
+            }
+            for (int j = 1; j < kTapsPerPhase; ++j) {
+                const float tap = taps[j];
+                const float* shifted = window + j;
+                for (size_t i = 0; i < n; ++i) {
+                    acc[i] += tap * shifted[i];
+                }
+            }
+            for (size_t i = 0; i < n; ++i) {
+                sampleLo[i] = std::min(sampleLo[i], acc[i]);
+                sampleHi[i] = std::max(sampleHi[i], acc[i]);
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            runLo[i] = std::min(runLo[i], sampleLo[i]);
+            runHi[i] = std::max(runHi[i], sampleHi[i]);
+        }
+        if (WritePeaks) {
+            for (size_t i = 0; i < n; ++i) {
+                peaks[start + i] = std::max(-sampleLo[i], sampleHi[i]);
+            }
+        }
+    }
+    min_ = *std::min_element(runLo, runLo + kBlock);
+    max_ = *std::max_element(runHi, runHi + kBlock);
+
+    // Keep the tail as history for the next chunk
+    std::copy(buffer_.end() - kHistory, buffer_.end(), buffer_.begin());
+    buffer_.resize(kHistory);
+}
+
+double TruePeakMeter::getTruePeakDb() const {
+    const float peak = getTruePeak();
+    return (peak > 0.0f) ? 20.0 * std::log10(peak) : -std::numeric_limits<double>::infinity();
+}
+
+LookAheadLimiter::LookAheadLimiter(int sampleRate, float ceiling, double lookAheadMs, double releaseMs)
+    : ceiling_(ceiling)
+{
+    // At least as long as the interpolator delay so true peaks are caught in time
+    lookAhead_ = std::max(TruePeakMeter::kTapsPerPhase,
+                          static_cast<int>(std::lround(lookAheadMs * 0.001 * sampleRate)));
+    const double releaseSamples = std::max(1.0, releaseMs * 0.001 * sampleRate);
+    releaseCoeff_ = static_cast<float>(1.0 - std::exp(-1.0 / releaseSamples));
+    reset();
+}
+
+void LookAheadLimiter::reset() {
+    detector_.reset();
+    delayLine_.assign(lookAhead_, 0.0f);
+    envelopeRing_.assign(lookAhead_, 1.0f);
+    envelopeSum_ = static_cast<double>(lookAhead_);
+    envelope_ = 1.0f;
+    minQueue_.clear();
+    samplesIn_ = 0;
+    samplesOut_ = 0;
+}
+
+size_t LookAheadLimiter::process(const float* in, size_t numSamples, float* out) {
+    // Detector first: reads the whole block, so in and out may alias
+    peaks_.resize(numSamples);
+    detector_.processPeaks(in, numSamples, peaks_.data());
+
+    const size_t window = static_cast<size_t>(lookAhead_);
+    const float invWindow = 1.0f / lookAhead_;
+    size_t written = 0;
+
+    for (size_t i = 0; i < numSamples; ++i) {
+        const size_t n = samplesIn_++;
+        const float peak = peaks_[i];
+        const float required = (peak > ceiling_) ? ceiling_ / peak : 1.0f;
+
+        // Sliding minimum of the required gain over the look-ahead window
+        while (!minQueue_.empty() && minQueue_.back().gain >= required) {
+            minQueue_.pop_back();
+        }
+        minQueue_.push_back({n, required});
+        while (minQueue_.front().index + window < n) {
+            minQueue_.pop_front();
+        }
+        const float hold = minQueue_.front().gain;
+
+        // Instant attack, exponential release
+        envelope_ = (hold < envelope_) ? hold : envelope_ + (hold - envelope_) * releaseCoeff_;
+
+        // Moving average over the window: ramps down ahead of the peak
+        const size_t slot = n % window;
+        envelopeSum_ += envelope_ - envelopeRing_[slot];
+        envelopeRing_[slot] = envelope_;
+        const float gain = std::min(1.0f, static_cast<float>(envelopeSum_) * invWindow);
+
+        const float delayed = delayLine_[slot];
+        delayLine_[slot] = in[i];
+        if (n >= window) {
+            out[written++] = delayed * gain;
+        }
+    }
+
+    samplesOut_ += written;
+    return written;
+}
+
+size_t LookAheadLimiter::flush(float* out) {
+    const size_t pending = samplesIn_ - samplesOut_;
+    std::vector<float> silence(lookAhead_, 0.0f);
+    std::vector<float> tail(lookAhead_);
+    const size_t written = process(silence.data(), silence.size(), tail.data());
+    const size_t count = std::min(pending, written);
+    std::copy(tail.begin(), tail.begin() + count, out);
+    return count;
+}
+
+LoudnessMeter::LoudnessMeter(int sampleRate) {
+    const double pi = 3.14159265358979323846;
+    const double fs = static_cast<double>(sampleRate);
+
+    // Stage 1: high-shelf (head effects), re-derived for any sample rate
+    {
+        const double f0 = 1681.974450955533;
+        const double gainDb = 3.999843853973347;
+        const double q = 0.7071752369554196;
+        const double k = std::tan(pi * f0 / fs);
+        const double vh = std::pow(10.0, gainDb / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+        shelf_.b0 = (vh + vb * k / q + k * k) / a0;
+        shelf_.b1 = 2.0 * (k * k - vh) / a0;
+        shelf_.b2 = (vh - vb * k / q + k * k) / a0;
+        shelf_.a1 = 2.0 * (k * k - 1.0) / a0;
+        shelf_.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    // Stage 2: RLB high-pass
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+        const double k = std::tan(pi * f0 / fs);
+        const double a0 = 1.0 + k / q + k * k;
+        highPass_.b0 = 1.0;
+        highPass_.b1 = -2.0;
+        highPass_.b2 = 1.0;
+        highPass_.a1 = 2.0 * (k * k - 1.0) / a0;
+        highPass_.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    stepSamples_ = std::max<size_t>(1, static_cast<size_t>(std::lround(fs * 0.1)));
+    reset();
+}
+
+void LoudnessMeter::reset() {
+    shelf_.z1 = shelf_.z2 = 0.0;
+    highPass_.z1 = highPass_.z2 = 0.0;
+    stepFill_ = 0;
+    stepEnergy_ = 0.0;
+    steps_.fill(0.0);
+    numSteps_ = 0;
+    blockEnergies_.clear();
+}
+
+void LoudnessMeter::process(const float* audio, size_t numSamples) {
+    for (size_t i = 0; i < numSamples; ++i) {
+        const double y = highPass_.process(shelf_.process(audio[i]));
+        stepEnergy_ += y * y;
+
+        if (++stepFill_ == stepSamples_) {
+            steps_[numSteps_ % steps_.size()] = stepEnergy_;
+            ++numSteps_;
+            stepFill_ = 0;
+            stepEnergy_ = 0.0;
+
+            // Every 100 ms step completes a 400 ms block once four are available
+            if (numSteps_ >= steps_.size()) {
+                const double energy = steps_[0] + steps_[1] + steps_[2] + steps_[3];
+                blockEnergies_.push_back(energy / static_cast<double>(stepSamples_ * steps_.size()));
+            }
+        }
+    }
+}
+
+double LoudnessMeter::getIntegratedLoudness(int numChannels) const {
+    const double channelGain = static_cast<double>(std::max(1, numChannels));
+    auto toLufs = [channelGain](double meanSquare) {
+        return -0.691 + 10.0 * std::log10(channelGain * meanSquare);
+    };
+
+    // Absolute gate
+    const double absoluteGate = -70.0;
+    double sum = 0.0;
+    size_t count = 0;
+    for (const double energy : blockEnergies_) {
+        if (energy > 0.0 && toLufs(energy) > absoluteGate) {
+            sum += energy;
+            ++count;
+        }
+    }
+    if (count == 0) {
+        return -std::numeric_limits<double>::infinity();
+    }
+
+    // Relative gate: 10 LU below the absolute-gated loudness
+    const double relativeGate = toLufs(sum / count) - 10.0;
+    double gatedSum = 0.0;
+    size_t gatedCount = 0;
+    for (const double energy : blockEnergies_) {
+        if (energy > 0.0) {
+            const double blockLufs = toLufs(energy);
+            if (blockLufs > absoluteGate && blockLufs > relativeGate) {
+                gatedSum += energy;
+                ++gatedCount;
+            }
+        }
+    }
+    return toLufs(gatedSum / gatedCount);
+}
+
+PostProcessor::PostProcessor(const PostProcessSettings& settings)
+    : settings_(settings)
+{
+    if (settings_.normalizeMode == NormalizeMode::Loudness) {
+        loudnessMeter_ = std::make_unique<LoudnessMeter>(settings_.sampleRate);
+    }
+    if (settings_.truePeak && settings_.safetyLimiter) {
+        limiter_ = std::make_unique<LookAheadLimiter>(settings_.sampleRate, settings_.limiterThreshold,
+                                                      settings_.lookAheadMs, settings_.releaseMs);
+    }
+}
+
+void PostProcessor::analyze(const float* audio, size_t numSamples) {
+    if (numSamples == 0) {
+        return;
+    }
+
+    std::mutex mergeMutex;
+    const bool first = (count_ == 0);
+    float chunkMin = audio[0];
+    float chunkMax = audio[0];
+    double chunkSum = 0.0;
+    double chunkCompensation = 0.0;
+
+    const int numBlocks = static_cast<int>((numSamples + kMinParallelSamples - 1) / kMinParallelSamples);
+    parallelFor(0, numBlocks, [&](int b0, int b1) {
+        const size_t begin = static_cast<size_t>(b0) * kMinParallelSamples;
+        const size_t end = std::min(numSamples, static_cast<size_t>(b1) * kMinParallelSamples);
+
+        // Per block: plain float sums (vectorizable), then compensated merge
+        double sum = 0.0;
+        double compensation = 0.0;
+        float lo = audio[begin];
+        float hi = audio[begin];
+        for (size_t block = begin; block < end; block += 1024) {
+            const size_t blockEnd = std::min(end, block + 1024);
+            float partial = 0.0f;
+            for (size_t i = block; i < blockEnd; ++i) {
+                partial += audio[i];
+                lo = std::min(lo, audio[i]);
+                hi = std::max(hi, audio[i]);
+            }
+            compensatedAdd(sum, compensation, partial);
+        }
+
+        std::lock_guard<std::mutex> lock(mergeMutex);
+        compensatedAdd(chunkSum, chunkCompensation, sum);
+        chunkCompensation += compensation;
+        chunkMin = std::min(chunkMin, lo);
+        chunkMax = std::max(chunkMax, hi);
+    });
+
+    if (settings_.truePeak) {
+        truePeakMeter_.process(audio, numSamples);
+    }
+    if (loudnessMeter_) {
+        // K-weighting high-pass removes DC, so the raw signal can be metered
+        loudnessMeter_->process(audio, numSamples);
+    }
+
+    compensatedAdd(sum_, compensation_, chunkSum);
+    compensation_ += chunkCompensation;
+    min_ = first ? chunkMin : std::min(min_, chunkMin);
+    max_ = first ? chunkMax : std::max(max_, chunkMax);
+    count_ += numSamples;
+}
+
+void PostProcessor::finalizeAnalysis() {
+    if (count_ == 0) {
+        mean_ = 0.0;
+        peak_ = 0.0f;
+        scale_ = 1.0f;
+        loudness_ = -std::numeric_limits<double>::infinity();
+        return;
+    }
+
+    mean_ = (sum_ + compensation_) / static_cast<double>(count_);
+
+    // Peak after DC removal
+    peak_ = static_cast<float>(std::max(max_ - mean_, mean_ - min_));
+    if (settings_.truePeak) {
+        // Each interpolator phase has unity DC gain, so DC shifts the extremes as-is
+        const double truePeak = std::max(truePeakMeter_.getMax() - mean_, mean_ - truePeakMeter_.getMin());
+        peak_ = std::max(peak_, static_cast<float>(truePeak));
+    }
+
+    const float gain = std::pow(10.0f, static_cast<float>(settings_.outputGainDb) / 20.0f);
+    float normalizeScale = 1.0f;
+    if (loudnessMeter_) {
+        loudness_ = loudnessMeter_->getIntegratedLoudness(settings_.outputChannels);
+        if (std::isfinite(loudness_)) { // Fully gated (silence): leave as is
+            normalizeScale = static_cast<float>(std::pow(10.0, (settings_.normalizeTargetLufs - loudness_) / 20.0));
+        }
+    } else if (peak_ >= 1e-8f) { // Avoid division by zero
+        const float targetLinear = std::pow(10.0f, static_cast<float>(settings_.normalizeTargetDbfs) / 20.0f);
+        normalizeScale = targetLinear / peak_;
+    }
+    scale_ = normalizeScale * gain;
+}
+
+void PostProcessor::apply(const float* in, size_t numSamples, float* out, int channels) {
+    if (!limiter_) {
+        applyStateless(in, numSamples, out, channels, settings_.safetyLimiter);
+        return;
+    }
+
+    // Output lags input by the limiter latency, so in-place mono is safe
+    limiter_->reset();
+    size_t written = 0;
+    for (size_t pos = 0; pos < numSamples; pos += kMinParallelSamples) {
+        const size_t count = std::min(numSamples - pos, static_cast<size_t>(kMinParallelSamples));
+        const bool final = (pos + count == numSamples);
+        written += process(in + pos, count, out + written * channels, channels, final);
+    }
+}
+
+size_t PostProcessor::process(const float* in, size_t numSamples, float* out, int channels, bool final) {
+    if (!limiter_) {
+        applyStateless(in, numSamples, out, channels, settings_.safetyLimiter);
+        return numSamples;
+    }
+
+    scratch_.resize(numSamples + limiter_->getLatency());
+    applyStateless(in, numSamples, scratch_.data(), 1, false);
+    size_t written = limiter_->process(scratch_.data(), numSamples, scratch_.data());
+    if (final) {
+        written += limiter_->flush(scratch_.data() + written);
+    }
+
+    for (size_t i = 0; i < written; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            out[i * channels + c] = scratch_[i];
+        }
+    }
+    return written;
+}
+
+int PostProcessor::getLatency() const {
+    return limiter_ ? limiter_->getLatency() : 0;
+}
+
+void PostProcessor::applyStateless(const float* in, size_t numSamples, float* out, int channels,
+                                   bool softClip) const {
+    const float mean = static_cast<float>(mean_);
+    const float scale = scale_;
+    const bool limiter = softClip;
+    const float threshold = settings_.limiterThreshold;
+
+    const int numBlocks = static_cast<int>((numSamples + kMinParallelSamples - 1) / kMinParallelSamples);
+    parallelFor(0, numBlocks, [&](int b0, int b1) {
+        const size_t begin = static_cast<size_t>(b0) * kMinParallelSamples;
+        const size_t end = std::min(numSamples, static_cast<size_t>(b1) * kMinParallelSamples);
+
+        for (size_t i = begin; i < end; ++i) {
+            float sample = (in[i] - mean) * scale;
+            if (limiter && std::abs(sample) > threshold) {
+                sample = Leveling::softClip(sample, threshold);
+            }
+            for (int c = 0; c < channels; ++c) {
+                out[i * channels + c] = sample;
+            }
+        }
+    });
+}
+
 } // namespace img2spec
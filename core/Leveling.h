@@ -1,5 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <memory>
 #include <vector>
 
 namespace img2spec {
@@ -25,7 +30,201 @@ public:
     static std::vector<float> monoToStereo(const std::vector<float>& mono);
 
 private:
+    friend class PostProcessor;
+
     static float softClip(float sample, float threshold);
 };
 
+// True-peak meter (ITU-R BS.1770 style): 4x polyphase oversampling,
+// block streaming. Tracks the signed extremes of the oversampled signal.
+class TruePeakMeter {
+public:
+    static constexpr int kOversampling = 4;
+    static constexpr int kTapsPerPhase = 12;
+
+    TruePeakMeter();
+
+    void reset();
+
+    // Accumulate a chunk (chunks must be contiguous in time)
+    void process(const float* audio, size_t numSamples);
+
+    // Like process(), also writes the per-sample detector value:
+    // peaks[i] = max |x| over the sample and its interpolated neighbours
+    void processPeaks(const float* audio, size_t numSamples, float* peaks);
+
+    // Signed extremes so far (0 before any sample)
+    float getMin() const { return started_ ? min_ : 0.0f; }
+    float getMax() const { return started_ ? max_ : 0.0f; }
+    float getTruePeak() const { return std::max(-getMin(), getMax()); }
+    double getTruePeakDb() const;
+
+private:
+    template <bool WritePeaks>
+    void run(const float* audio, size_t numSamples, float* peaks);
+
+    // Per phase, taps stored in time-reversed order for contiguous dot products
+    std::array<std::array<float, kTapsPerPhase>, kOversampling> phases_;
+    std::vector<float> buffer_; // kTapsPerPhase - 1 samples of history + block
+    bool started_ = false;      // history holds the first sample once audio arrived
+    float min_ = 0.0f;
+    float max_ = 0.0f;
+};
+
+// Look-ahead brickwall limiter with a true-peak detector.
+// Gain reductions are found lookAhead samples in advance (sliding minimum),
+// released exponentially and smoothed by a moving average of the same
+// length, so the gain is fully down when the peak reaches the output.
+// Output lags input by getLatency() samples.
+class LookAheadLimiter {
+public:
+    LookAheadLimiter(int sampleRate, float ceiling, double lookAheadMs = 5.0, double releaseMs = 50.0);
+
+    void reset();
+    int getLatency() const { return lookAhead_; }
+
+    // Process a block; returns the number of samples written to out
+    // (numSamples once the look-ahead delay has filled)
+    size_t process(const float* in, size_t numSamples, float* out);
+
+    // Drain the delay line; writes getLatency() samples (or fewer if less input was seen)
+    size_t flush(float* out);
+
+private:
+    struct MinEntry {
+        size_t index;
+        float gain;
+    };
+
+    TruePeakMeter detector_;
+    int lookAhead_;
+    float ceiling_;
+    float releaseCoeff_;
+
+    std::vector<float> delayLine_;
+    std::vector<float> envelopeRing_;
+    std::deque<MinEntry> minQueue_;
+    std::vector<float> peaks_;
+    double envelopeSum_ = 0.0;
+    float envelope_ = 1.0f;
+    size_t samplesIn_ = 0;
+    size_t samplesOut_ = 0;
+};
+
+// Integrated loudness meter (ITU-R BS.1770 / EBU R128): K-weighting,
+// 400 ms gating blocks with 75% overlap, absolute (-70 LUFS) and relative
+// (-10 LU) gates. Incremental: feed mono chunks in order through process().
+class LoudnessMeter {
+public:
+    explicit LoudnessMeter(int sampleRate);
+
+    void reset();
+
+    void process(const float* audio, size_t numSamples);
+
+    // Integrated loudness in LUFS of numChannels identical channels
+    // (mono duplicated to stereo reads 3 LU louder); -inf if fully gated
+    double getIntegratedLoudness(int numChannels = 1) const;
+
+    size_t getNumBlocks() const { return blockEnergies_.size(); }
+
+private:
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+        double z1 = 0.0;
+        double z2 = 0.0;
+
+        double process(double x) {
+            const double y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    Biquad shelf_;
+    Biquad highPass_;
+    size_t stepSamples_;               // 100 ms
+    size_t stepFill_ = 0;
+    double stepEnergy_ = 0.0;
+    std::array<double, 4> steps_ = {}; // last four 100 ms energies
+    size_t numSteps_ = 0;
+    std::vector<double> blockEnergies_; // mean square per 400 ms block
+};
+
+enum class NormalizeMode {
+    Peak,     // sample or true peak to normalizeTargetDbfs
+    Loudness  // integrated loudness to normalizeTargetLufs
+};
+
+struct PostProcessSettings {
+    NormalizeMode normalizeMode = NormalizeMode::Peak;
+    double normalizeTargetDbfs = -1.0;
+    double normalizeTargetLufs = -23.0;
+    int outputChannels = 1; // channel count the loudness target refers to
+    double outputGainDb = 0.0;
+    bool safetyLimiter = true;
+    float limiterThreshold = 0.99f;
+
+    // True peak: normalize on the oversampled peak and, with the safety
+    // limiter enabled, use the look-ahead brickwall limiter at limiterThreshold
+    bool truePeak = false;
+    int sampleRate = 44100;
+    double lookAheadMs = 5.0;
+    double releaseMs = 50.0;
+};
+
+// Fused post-processing chain: DC removal, peak normalization, output gain
+// and safety limiter in two passes instead of one pass per stage.
+// 1) analyze(): parallel reduction of mean (compensated sum) and min/max,
+//    plus loudness in NormalizeMode::Loudness; may be called once per chunk
+// 2) apply(): subtract DC, scale, limit and interleave to N channels
+class PostProcessor {
+public:
+    explicit PostProcessor(const PostProcessSettings& settings);
+
+    // Accumulate statistics for a chunk of mono samples
+    void analyze(const float* audio, size_t numSamples);
+
+    // Derive DC offset and scale from everything analyzed so far
+    void finalizeAnalysis();
+
+    // Process a whole mono signal into out (numSamples * channels, interleaved).
+    // in and out may alias when channels == 1.
+    void apply(const float* in, size_t numSamples, float* out, int channels = 1);
+
+    // Streaming apply: call for consecutive chunks, with final = true on the
+    // last one. Returns frames written; output lags input by getLatency()
+    // frames, so out must hold (numSamples + getLatency()) * channels.
+    size_t process(const float* in, size_t numSamples, float* out, int channels, bool final);
+
+    int getLatency() const;
+
+    double getMean() const { return mean_; }
+    float getPeak() const { return peak_; }
+    float getScale() const { return scale_; }
+    double getIntegratedLoudness() const { return loudness_; }
+
+private:
+    void applyStateless(const float* in, size_t numSamples, float* out, int channels, bool softClip) const;
+
+    const PostProcessSettings settings_;
+    TruePeakMeter truePeakMeter_;
+    std::unique_ptr<LoudnessMeter> loudnessMeter_;
+    std::unique_ptr<LookAheadLimiter> limiter_;
+    std::vector<float> scratch_;
+
+    // Neumaier-compensated running sum plus extremes
+    double sum_ = 0.0;
+    double compensation_ = 0.0;
+    float min_ = 0.0f;
+    float max_ = 0.0f;
+    size_t count_ = 0;
+
+    double mean_ = 0.0;
+    float peak_ = 0.0f;
+    float scale_ = 1.0f;
+    double loudness_ = 0.0;
+};
+
 } // namespace img2spec
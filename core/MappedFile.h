@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace img2spec {
+
+/**
+ * MappedFile: Memory mapping of a whole file
+ * - POSIX mmap / Win32 file mapping
+ * - Pages are loaded on demand by the OS, nothing is copied up front
+ * - Read-only, or a newly created file of fixed size for writing
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Map file for reading
+     * @return true if successful (empty files cannot be mapped)
+     */
+    bool openReadOnly(const std::string& path);
+
+    /**
+     * Create (or truncate) a file, preallocate it to size bytes and map it
+     * for writing
+     * @return true if successful
+     */
+    bool createReadWrite(const std::string& path, size_t size);
+
+    void close();
+
+    bool isOpen() const { return data_ != nullptr; }
+    const unsigned char* data() const { return static_cast<const unsigned char*>(data_); }
+    unsigned char* mutableData() { return writable_ ? static_cast<unsigned char*>(data_) : nullptr; }
+    size_t size() const { return size_; }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+    bool writable_ = false;
+#ifdef _WIN32
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+};
+
+} // namespace img2spec
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace img2spec {
+
+// Run fn(chunkBegin, chunkEnd) over [begin, end), split into contiguous
+// chunks of at least minChunk items across the hardware threads.
+// The calling thread processes the first chunk; fn must not throw.
+template <typename Fn>
+void parallelFor(int begin, int end, Fn fn, int minChunk = 1) {
+    const int count = end - begin;
+    if (count <= 0) {
+        return;
+    }
+
+    const int hardwareThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    const int numChunks = std::min(hardwareThreads, (count + minChunk - 1) / std::max(1, minChunk));
+    if (numChunks <= 1) {
+        fn(begin, end);
+        return;
+    }
+
+    const int chunkSize = (count + numChunks - 1) / numChunks;
+    std::vector<std::thread> workers;
+    workers.reserve(numChunks - 1);
+    for (int chunkBegin = begin + chunkSize; chunkBegin < end; chunkBegin += chunkSize) {
+        const int chunkEnd = std::min(chunkBegin + chunkSize, end);
+        workers.emplace_back([&fn, chunkBegin, chunkEnd]() { fn(chunkBegin, chunkEnd); });
+    }
+
+    fn(begin, std::min(begin + chunkSize, end));
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace img2spec
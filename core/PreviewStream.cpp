@@ -0,0 +1,92 @@
+#include "core/PreviewStream.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace img2spec {
+
+PreviewStream::PreviewStream(size_t maxQueuedSamples, size_t blockSamples)
+    : blockSamples_(std::max<size_t>(1, blockSamples))
+    , maxQueuedSamples_(std::max(maxQueuedSamples, blockSamples_))
+    , queue_(maxQueuedSamples_ / blockSamples_ + 1)
+    , recycle_(maxQueuedSamples_ / blockSamples_ + 1)
+{
+}
+
+bool PreviewStream::push(const float* samples, size_t count, const std::atomic<bool>* cancelFlag) {
+    auto stopped = [&]() {
+        return closed_.load(std::memory_order_acquire)
+            || (cancelFlag && cancelFlag->load(std::memory_order_relaxed));
+    };
+
+    while (count > 0) {
+        const size_t n = std::min(count, blockSamples_);
+
+        // Playback drains the queue in real time, so waits here last up to a
+        // block's duration; sleep rather than spin
+        while (queuedSamples_.load(std::memory_order_relaxed) + n > maxQueuedSamples_) {
+            if (stopped()) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        std::vector<float> block;
+        recycle_.tryPop(block);
+        block.assign(samples, samples + n);
+
+        queuedSamples_.fetch_add(n, std::memory_order_relaxed);
+        while (!queue_.tryPush(std::move(block))) {
+            if (stopped()) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        samples += n;
+        count -= n;
+    }
+    return !stopped();
+}
+
+void PreviewStream::finish() {
+    // All pushes happen before finished is set
+    finished_.store(true, std::memory_order_release);
+}
+
+size_t PreviewStream::read(float* out, size_t count) {
+    size_t done = 0;
+    while (done < count) {
+        if (currentPos_ == current_.size()) {
+            if (!current_.empty()) {
+                recycle_.tryPush(std::move(current_));
+                current_.clear();
+            }
+            currentPos_ = 0;
+            if (!queue_.tryPop(current_)) {
+                break;
+            }
+        }
+
+        const size_t n = std::min(count - done, current_.size() - currentPos_);
+        std::memcpy(out + done, current_.data() + currentPos_, n * sizeof(float));
+        currentPos_ += n;
+        done += n;
+    }
+
+    queuedSamples_.fetch_sub(done, std::memory_order_relaxed);
+    return done;
+}
+
+bool PreviewStream::atEnd() const {
+    return finished_.load(std::memory_order_acquire)
+        && currentPos_ == current_.size()
+        && queue_.empty();
+}
+
+void PreviewStream::close() {
+    closed_.store(true, std::memory_order_release);
+}
+
+} // namespace img2spec
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "core/SpscRing.h"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace img2spec {
+
+/**
+ * Mono audio handed from a render thread to a playback thread while it is
+ * still being rendered (progressive preview).
+ *
+ * Samples travel in blocks through a lock-free SPSC queue, and emptied
+ * blocks come back through a second queue, as in the async WavWriter. The
+ * producer waits while maxQueuedSamples are buffered, so a render running
+ * far ahead of the playhead holds a bounded amount of memory.
+ */
+class PreviewStream {
+public:
+    explicit PreviewStream(size_t maxQueuedSamples, size_t blockSamples = 4096);
+
+    PreviewStream(const PreviewStream&) = delete;
+    PreviewStream& operator=(const PreviewStream&) = delete;
+
+    // Producer side. push() returns false if the consumer closed the stream
+    // or cancelFlag was raised while waiting for space.
+    bool push(const float* samples, size_t count, const std::atomic<bool>* cancelFlag = nullptr);
+    // No more samples will be pushed
+    void finish();
+
+    // Consumer side. read() copies up to count samples and returns how many
+    // were available; fewer than count means an underrun unless atEnd().
+    size_t read(float* out, size_t count);
+    bool atEnd() const;
+    // The consumer stopped; a waiting producer gives up
+    void close();
+    bool isClosed() const { return closed_.load(std::memory_order_acquire); }
+
+    // Samples pushed but not yet read (approximate when called concurrently)
+    size_t getQueuedSamples() const { return queuedSamples_.load(std::memory_order_relaxed); }
+
+private:
+    const size_t blockSamples_;
+    const size_t maxQueuedSamples_;
+    SpscRing<std::vector<float>> queue_;
+    SpscRing<std::vector<float>> recycle_;
+    std::atomic<size_t> queuedSamples_{0};
+    std::atomic<bool> finished_{false};
+    std::atomic<bool> closed_{false};
+
+    // Consumer state: block being read and read position in it
+    std::vector<float> current_;
+    size_t currentPos_ = 0;
+};
+
+} // namespace img2spec
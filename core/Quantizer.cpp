@@ -0,0 +1,104 @@
+#include "core/Quantizer.h"
+#include <algorithm>
+
+namespace img2spec {
+
+namespace {
+
+// Round to nearest, ties to even, without calling lrint(): adding and
+// subtracting 1.5 * 2^52 in double precision leaves the rounded integer
+// (exact for |v| < 2^51), and plain arithmetic vectorizes
+inline int32_t roundToInt(double v) {
+    constexpr double kMagic = 6755399441055744.0;
+    return static_cast<int32_t>((v + kMagic) - kMagic);
+}
+
+template <typename T, int Shift>
+void quantizePlain(const float* in, size_t numSamples, T* out, float scale) {
+    for (size_t i = 0; i < numSamples; ++i) {
+        float x = in[i];
+        x = (x < -1.0f) ? -1.0f : x;
+        x = (x > 1.0f) ? 1.0f : x;
+        out[i] = static_cast<T>(roundToInt(static_cast<double>(x * scale)) * (1 << Shift));
+    }
+}
+
+} // namespace
+
+Quantizer::Quantizer(int bits, int channels, const DitherSettings& dither)
+    : bits_(bits)
+    , channels_(std::max(1, channels))
+    , dither_(dither)
+    , scale_(static_cast<float>((1 << (bits - 1)) - 1))
+{
+    reset();
+}
+
+void Quantizer::reset() {
+    rng_ = dither_.seed ? dither_.seed : 1u;
+    channel_ = 0;
+    error_.assign(channels_, 0.0f);
+}
+
+float Quantizer::nextTpdf() {
+    // xorshift32; two uniforms in [0, 1) give a triangular PDF in (-1, 1)
+    auto next = [this]() {
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 17;
+        rng_ ^= rng_ << 5;
+        return static_cast<float>(rng_ >> 8) * (1.0f / 16777216.0f);
+    };
+    const float a = next();
+    const float b = next();
+    return a - b;
+}
+
+void Quantizer::quantize(const float* in, size_t numSamples, int16_t* out) {
+    if (dither_.tpdf || dither_.noiseShaping) {
+        quantizeDithered<int16_t, 0>(in, numSamples, out);
+    } else {
+        quantizePlain<int16_t, 0>(in, numSamples, out, scale_);
+    }
+}
+
+void Quantizer::quantize(const float* in, size_t numSamples, int32_t* out) {
+    if (dither_.tpdf || dither_.noiseShaping) {
+        quantizeDithered<int32_t, 8>(in, numSamples, out);
+    } else {
+        quantizePlain<int32_t, 8>(in, numSamples, out, scale_);
+    }
+}
+
+template <typename T, int Shift>
+void Quantizer::quantizeDithered(const float* in, size_t numSamples, T* out) {
+    const float lo = -scale_ - 1.0f;
+    const float hi = scale_;
+
+    for (size_t i = 0; i < numSamples; ++i) {
+        float x = in[i];
+        x = (x < -1.0f) ? -1.0f : x;
+        x = (x > 1.0f) ? 1.0f : x;
+
+        // Error feedback: subtract the previous error of this channel
+        float target = x * scale_;
+        if (dither_.noiseShaping) {
+            target -= error_[channel_];
+        }
+
+        float value = target;
+        if (dither_.tpdf) {
+            value += nextTpdf();
+        }
+        value = std::min(hi, std::max(lo, value));
+        const int32_t q = roundToInt(static_cast<double>(value));
+
+        error_[channel_] = static_cast<float>(q) - target;
+        out[i] = static_cast<T>(q * (1 << Shift));
+
+        if (++channel_ == static_cast<size_t>(channels_)) {
+            channel_ = 0;
+        }
+    }
+}
+
+} // namespace img2spec
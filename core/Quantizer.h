@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace img2spec {
+
+struct DitherSettings {
+    bool tpdf = false;          // triangular PDF dither, +/-1 LSB peak
+    bool noiseShaping = false;  // first-order error feedback (pushes noise up in frequency)
+    uint32_t seed = 0x2545F491; // fixed default: identical input gives identical files
+};
+
+// Float -> PCM integer conversion shared by all WAV backends.
+// Without dither: clamp to [-1, 1], round to nearest (ties to even) at
+// x * (2^(bits-1) - 1); this loop is branch-free and vectorizes.
+// With dither: per-channel noise shaping state carries across calls, so
+// interleaved chunks can be quantized one after another.
+class Quantizer {
+public:
+    Quantizer(int bits, int channels, const DitherSettings& dither = DitherSettings());
+
+    void reset();
+
+    int getBits() const { return bits_; }
+
+    // 16-bit output (bits == 16)
+    void quantize(const float* in, size_t numSamples, int16_t* out);
+
+    // 24-bit output left-justified in int32 (value << 8), the full-scale
+    // int convention of libsndfile's sf_writef_int (bits == 24)
+    void quantize(const float* in, size_t numSamples, int32_t* out);
+
+private:
+    template <typename T, int Shift>
+    void quantizeDithered(const float* in, size_t numSamples, T* out);
+
+    float nextTpdf();
+
+    int bits_;
+    int channels_;
+    DitherSettings dither_;
+    float scale_;
+    uint32_t rng_ = 0;
+    size_t channel_ = 0;        // channel of the next sample (interleaved position)
+    std::vector<float> error_;  // last quantization error per channel
+};
+
+} // namespace img2spec
@@ -0,0 +1,206 @@
+#include "core/RawMatrix.h"
+#include "core/MappedFile.h"
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <regex>
+
+namespace img2spec {
+
+namespace {
+
+constexpr unsigned char kNpyMagic[6] = {0x93, 'N', 'U', 'M', 'P', 'Y'};
+constexpr char kRawMagic[4] = {'I', '2', 'S', 'F'};
+constexpr size_t kRawHeaderSize = 24;
+
+uint32_t readLE32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+         | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+bool isLittleEndianHost() {
+    const uint16_t probe = 1;
+    unsigned char first = 0;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+} // namespace
+
+RawMatrix::RawMatrix() {}
+
+RawMatrix::~RawMatrix() {}
+
+bool RawMatrix::isRawMatrixFile(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    unsigned char magic[6] = {0};
+    const size_t n = std::fread(magic, 1, sizeof(magic), file);
+    std::fclose(file);
+
+    return (n >= 6 && std::memcmp(magic, kNpyMagic, 6) == 0)
+        || (n >= 4 && std::memcmp(magic, kRawMagic, 4) == 0);
+}
+
+void RawMatrix::close() {
+    file_.reset();
+    data_ = nullptr;
+    rows_ = 0;
+    cols_ = 0;
+    content_ = MatrixContent::Intensity;
+}
+
+bool RawMatrix::parseNpyHeader(const unsigned char* bytes, size_t size, size_t& dataOffset) {
+    if (size < 10 || std::memcmp(bytes, kNpyMagic, 6) != 0) {
+        return false;
+    }
+
+    const int major = bytes[6];
+    size_t headerLen = 0;
+    size_t headerStart = 0;
+    if (major == 1) {
+        headerLen = static_cast<size_t>(bytes[8]) | (static_cast<size_t>(bytes[9]) << 8);
+        headerStart = 10;
+    } else if (major == 2 || major == 3) {
+        if (size < 12) {
+            return false;
+        }
+        headerLen = readLE32(bytes + 8);
+        headerStart = 12;
+    } else {
+        std::cerr << "RawMatrix: Unsupported .npy version " << major << std::endl;
+        return false;
+    }
+
+    if (headerStart + headerLen > size) {
+        return false;
+    }
+
+    const std::string header(reinterpret_cast<const char*>(bytes + headerStart), headerLen);
+
+    std::smatch match;
+    if (!std::regex_search(header, match, std::regex("'descr'\\s*:\\s*'([^']*)'"))
+        || (match[1] != "<f4" && match[1] != "=f4")) {
+        std::cerr << "RawMatrix: .npy dtype must be little-endian float32 ('<f4')" << std::endl;
+        return false;
+    }
+    if (std::regex_search(header, match, std::regex("'fortran_order'\\s*:\\s*True"))) {
+        std::cerr << "RawMatrix: .npy must be C-ordered (fortran_order=False)" << std::endl;
+        return false;
+    }
+    if (!std::regex_search(header, match, std::regex("'shape'\\s*:\\s*\\(\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,?\\s*\\)"))) {
+        std::cerr << "RawMatrix: .npy must be a 2-D array" << std::endl;
+        return false;
+    }
+
+    // Dimensions must fit an int (like the I2SF header); digits only, so
+    // from_chars fails on overflow alone
+    auto parseDimension = [](const std::string& digits, int* value) {
+        uint64_t parsed = 0;
+        const auto result = std::from_chars(digits.data(), digits.data() + digits.size(), parsed);
+        if (result.ec != std::errc() || parsed > 0x7fffffffu) {
+            return false;
+        }
+        *value = static_cast<int>(parsed);
+        return true;
+    };
+    int rows = 0;
+    int cols = 0;
+    if (!parseDimension(match[1], &rows) || !parseDimension(match[2], &cols)) {
+        std::cerr << "RawMatrix: .npy shape is too large" << std::endl;
+        return false;
+    }
+
+    rows_ = rows;
+    cols_ = cols;
+    content_ = MatrixContent::Intensity;
+    dataOffset = headerStart + headerLen;
+    return true;
+}
+
+bool RawMatrix::parseRawHeader(const unsigned char* bytes, size_t size, size_t& dataOffset) {
+    if (size < kRawHeaderSize || std::memcmp(bytes, kRawMagic, 4) != 0) {
+        return false;
+    }
+
+    const uint32_t version = readLE32(bytes + 4);
+    if (version != 1) {
+        std::cerr << "RawMatrix: Unsupported I2SF version " << version << std::endl;
+        return false;
+    }
+
+    const uint32_t rows = readLE32(bytes + 8);
+    const uint32_t cols = readLE32(bytes + 12);
+    const uint32_t content = readLE32(bytes + 16);
+    if (rows > 0x7fffffffu || cols > 0x7fffffffu || content > 1) {
+        return false;
+    }
+
+    rows_ = static_cast<int>(rows);
+    cols_ = static_cast<int>(cols);
+    content_ = (content == 1) ? MatrixContent::Magnitude : MatrixContent::Intensity;
+    dataOffset = kRawHeaderSize;
+    return true;
+}
+
+bool RawMatrix::open(const std::string& path) {
+    close();
+
+    if (!isLittleEndianHost()) {
+        std::cerr << "RawMatrix: Big-endian hosts are not supported" << std::endl;
+        return false;
+    }
+
+    auto file = std::make_shared<MappedFile>();
+    if (!file->openReadOnly(path)) {
+        std::cerr << "RawMatrix: Failed to map file: " << path << std::endl;
+        return false;
+    }
+
+    size_t dataOffset = 0;
+    if (!parseNpyHeader(file->data(), file->size(), dataOffset)
+        && !parseRawHeader(file->data(), file->size(), dataOffset)) {
+        std::cerr << "RawMatrix: Not a float32 .npy or I2SF file: " << path << std::endl;
+        rows_ = 0;
+        cols_ = 0;
+        return false;
+    }
+
+    // Compared by division: rows * cols * 4 can overflow for a bogus header
+    const size_t availableFloats = (dataOffset <= file->size()) ? (file->size() - dataOffset) / sizeof(float) : 0;
+    if (rows_ <= 0 || cols_ <= 0 || availableFloats / static_cast<size_t>(cols_) < static_cast<size_t>(rows_)) {
+        std::cerr << "RawMatrix: Truncated or empty matrix: " << path << std::endl;
+        rows_ = 0;
+        cols_ = 0;
+        return false;
+    }
+    if (dataOffset % alignof(float) != 0) {
+        std::cerr << "RawMatrix: Misaligned matrix data: " << path << std::endl;
+        rows_ = 0;
+        cols_ = 0;
+        return false;
+    }
+
+    file_ = file;
+    data_ = reinterpret_cast<const float*>(file->data() + dataOffset);
+
+    std::cout << "RawMatrix: Mapped " << path << std::endl;
+    std::cout << "  Shape: " << rows_ << "x" << cols_ << " float32" << std::endl;
+    std::cout << "  Content: " << (content_ == MatrixContent::Magnitude ? "Magnitude" : "Intensity") << std::endl;
+
+    return true;
+}
+
+GrayscalePlane RawMatrix::asPlane() const {
+    if (!isOpen()) {
+        return GrayscalePlane();
+    }
+    return GrayscalePlane::wrap(data_, cols_, rows_, PixelFormat::Float32, file_);
+}
+
+} // namespace img2spec
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "core/GrayscalePlane.h"
+
+namespace img2spec {
+
+class MappedFile;
+
+enum class MatrixContent {
+    Intensity, // Image-like [0.0, 1.0]; rows = frequency (top = high), cols = frames
+    Magnitude  // Linear STFT magnitudes; rows = frames, cols = fftSize/2+1 bins
+};
+
+/**
+ * RawMatrix: Memory-mapped float32 matrix input, bypassing image decode
+ * - NumPy .npy: little-endian float32 ('<f4'), C order, 2-D shape (rows, cols);
+ *   content is Intensity unless overridden
+ * - Raw .f32: 24-byte header followed by row-major little-endian float32
+ *     char[4]  magic "I2SF"
+ *     uint32   version (1)
+ *     uint32   rows
+ *     uint32   cols
+ *     uint32   content (0 = intensity, 1 = magnitude)
+ *     uint32   reserved (0)
+ * - Data is used in place (zero-copy); the mapping stays alive as long as
+ *   the RawMatrix or any plane created from it
+ */
+class RawMatrix {
+public:
+    RawMatrix();
+    ~RawMatrix();
+
+    /**
+     * Check file signature (.npy or I2SF) without mapping the data
+     */
+    static bool isRawMatrixFile(const std::string& path);
+
+    /**
+     * Map matrix file
+     * @return true if successful
+     */
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return data_ != nullptr; }
+    int getRows() const { return rows_; }
+    int getCols() const { return cols_; }
+    MatrixContent getContent() const { return content_; }
+    void setContent(MatrixContent content) { content_ = content; }
+
+    /**
+     * Row-major float32 data, rows x cols
+     */
+    const float* data() const { return data_; }
+    const float* row(int r) const { return data_ + static_cast<size_t>(r) * cols_; }
+
+    /**
+     * Intensity matrix as a Float32 plane (shares the mapping)
+     */
+    GrayscalePlane asPlane() const;
+
+private:
+    bool parseNpyHeader(const unsigned char* bytes, size_t size, size_t& dataOffset);
+    bool parseRawHeader(const unsigned char* bytes, size_t size, size_t& dataOffset);
+
+    std::shared_ptr<MappedFile> file_;
+    const float* data_ = nullptr;
+    int rows_ = 0;
+    int cols_ = 0;
+    MatrixContent content_ = MatrixContent::Intensity;
+};
+
+} // namespace img2spec
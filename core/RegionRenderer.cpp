@@ -0,0 +1,242 @@
+#include "core/RegionRenderer.h"
+#include "core/GriffinLim.h"
+#include "core/Resampler.h"
+#include "core/Stft.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+namespace img2spec {
+
+RegionRenderer::RegionRenderer(const RenderSettings& settings)
+    : settings_(settings)
+{
+}
+
+bool RegionRenderer::findChangedColumns(const GrayscalePlane& before, const GrayscalePlane& after,
+                                        int* begin, int* end) {
+    if (before.isEmpty() || after.isEmpty()
+        || before.getWidth() != after.getWidth() || before.getHeight() != after.getHeight()
+        || before.getFormat() != after.getFormat()) {
+        return false;
+    }
+
+    const size_t bytesPerPixel = after.getBytesPerPixel();
+    const size_t rowBytes = static_cast<size_t>(after.getWidth()) * bytesPerPixel;
+    const uint8_t* a = static_cast<const uint8_t*>(before.data());
+    const uint8_t* b = static_cast<const uint8_t*>(after.data());
+
+    // Byte range [first, last) that differs in any row. Unchanged rows are
+    // skipped with memcmp; in changed rows only the bytes outside the range
+    // found so far can widen it.
+    size_t first = rowBytes;
+    size_t last = 0;
+    for (int y = 0; y < after.getHeight(); ++y, a += rowBytes, b += rowBytes) {
+        if (std::memcmp(a, b, rowBytes) == 0) {
+            continue;
+        }
+        size_t i = 0;
+        while (i < first && a[i] == b[i]) {
+            ++i;
+        }
+        first = std::min(first, i);
+        size_t j = rowBytes;
+        while (j > last && a[j - 1] == b[j - 1]) {
+            --j;
+        }
+        last = std::max(last, j);
+    }
+    if (first >= last) {
+        return false;
+    }
+
+    *begin = static_cast<int>(first / bytesPerPixel);
+    *end = static_cast<int>((last + bytesPerPixel - 1) / bytesPerPixel);
+    return true;
+}
+
+bool RegionRenderer::render(
+    const GrayscalePlane& image,
+    int columnBegin,
+    int columnEnd,
+    const RenderStages& base,
+    RenderStages& result,
+    ProgressCallback progressCallback,
+    const std::atomic<bool>* cancelFlag,
+    std::string* errorMessage
+) {
+    auto fail = [errorMessage](const std::string& message) {
+        std::cerr << "RegionRenderer: " << message << std::endl;
+        if (errorMessage) {
+            *errorMessage = message;
+        }
+        return false;
+    };
+    auto cancelled = [cancelFlag]() { return cancelFlag && cancelFlag->load(std::memory_order_relaxed); };
+
+    if (image.isEmpty() || !base.magnitude || !base.reconstruction || !base.audio) {
+        return fail("No previous render to patch");
+    }
+
+    const RenderPlan plan = planRender(settings_, image.getWidth());
+    const SpectrogramParams& params = plan.params;
+    const int numFrames = plan.numFrames;
+    const int numSourceFrames = plan.numSourceFrames;
+    const int fftSize = params.fftSize;
+    const int hopSize = params.hopSize;
+    if (numFrames <= 0 || fftSize <= 0 || hopSize <= 0) {
+        return fail("Invalid render parameters");
+    }
+    const size_t renderLength = static_cast<size_t>(fftSize) + static_cast<size_t>(numFrames - 1) * hopSize;
+    if (static_cast<int>(base.magnitude->size()) != numFrames || base.reconstruction->size() != renderLength) {
+        return fail("Previous render does not match the settings");
+    }
+    if (columnBegin < 0 || columnEnd > numSourceFrames || columnBegin >= columnEnd) {
+        return fail("Invalid column range");
+    }
+
+    // Frames fed by the changed columns. A stretched frame blends two
+    // neighbouring columns; the range is widened by one frame for rounding.
+    int frameBegin = columnBegin;
+    int frameEnd = columnEnd;
+    if (numFrames != numSourceFrames) {
+        if (numSourceFrames <= 1) {
+            frameBegin = 0;
+            frameEnd = numFrames;
+        } else {
+            const double scale = (numFrames - 1.0) / (numSourceFrames - 1.0);
+            frameBegin = std::max(0, static_cast<int>(std::floor((columnBegin - 1) * scale)) - 1);
+            frameEnd = std::min(numFrames, static_cast<int>(std::ceil(columnEnd * scale)) + 2);
+        }
+    }
+
+    // Margins of locked frames on both sides. Three frame lengths: the
+    // crossfade sits one frame in from the window edge (where fewer frames
+    // overlap) and ends a frame before the first re-solved sample.
+    const int marginFrames = std::max(settings_.marginFrames, 3 * ((fftSize + hopSize - 1) / hopSize));
+    const int windowBegin = std::max(0, frameBegin - marginFrames);
+    const int windowEnd = std::min(numFrames, frameEnd + marginFrames);
+    const int windowFrames = windowEnd - windowBegin;
+
+    std::cout << "RegionRenderer: columns [" << columnBegin << ", " << columnEnd << ") -> frames ["
+              << frameBegin << ", " << frameEnd << "), window of " << windowFrames << " / "
+              << numFrames << " frames" << std::endl;
+
+    // Step 1: rebuild the affected magnitude frames
+    auto magnitude = std::make_shared<RenderStages::Magnitude>(*base.magnitude);
+    FrameSource frameSource(image, plan);
+    const int numBins = frameSource.getNumBins();
+    std::vector<float> frames;
+    frameSource.build(frameBegin, frameEnd, frames);
+    for (int t = frameBegin; t < frameEnd; ++t) {
+        const float* frame = frames.data() + static_cast<size_t>(t - frameBegin) * numBins;
+        (*magnitude)[t].assign(frame, frame + numBins);
+    }
+
+    // Step 2: warm start from the previous phase, re-analyzed from the
+    // previous reconstruction
+    const std::vector<float>& previous = *base.reconstruction;
+    const size_t windowStartSample = static_cast<size_t>(windowBegin) * hopSize;
+    const size_t windowLength = static_cast<size_t>(fftSize) + static_cast<size_t>(windowFrames - 1) * hopSize;
+
+    Stft stft(fftSize, hopSize);
+    stft.setVerbose(false);
+    stft.setCancelFlag(cancelFlag);
+    const std::vector<float> segment(previous.begin() + windowStartSample,
+                                     previous.begin() + windowStartSample + windowLength);
+    const auto analysis = stft.forward(segment);
+    if (cancelled()) {
+        return fail("Cancelled");
+    }
+    if (static_cast<int>(analysis.size()) != windowFrames) {
+        return fail("Phase analysis failed");
+    }
+
+    std::vector<std::vector<float>> phase(windowFrames, std::vector<float>(numBins));
+    std::vector<const float*> framePointers(windowFrames);
+    for (int t = 0; t < windowFrames; ++t) {
+        for (int k = 0; k < numBins; ++k) {
+            phase[t][k] = std::arg(analysis[t][k]);
+        }
+        framePointers[t] = (*magnitude)[windowBegin + t].data();
+    }
+
+    // Step 3: local Griffin-Lim, margins locked
+    GriffinLim griffinLim;
+    const std::vector<float> audio = griffinLim.reconstructRegion(
+        framePointers, numBins, stft, settings_.iterations, phase,
+        frameBegin - windowBegin, windowEnd - frameEnd, progressCallback, cancelFlag);
+    if (cancelled()) {
+        return fail("Cancelled");
+    }
+    if (audio.size() < windowLength) {
+        return fail("Griffin-Lim reconstruction failed");
+    }
+
+    // Step 4: splice into a copy of the previous reconstruction with
+    // raised-cosine crossfades; at the signal edges the window is taken as is
+    const size_t fade = static_cast<size_t>(fftSize);
+    const bool fadeIn = windowBegin > 0;
+    const bool fadeOut = windowEnd < numFrames;
+    const size_t spliceBegin = fadeIn ? windowStartSample + fade : 0;
+    const size_t spliceEnd = fadeOut ? windowStartSample + windowLength - fade : renderLength;
+
+    auto reconstruction = std::make_shared<std::vector<float>>(previous);
+    float* dst = reconstruction->data();
+    for (size_t i = spliceBegin; i < spliceEnd; ++i) {
+        float w = 1.0f;
+        if (fadeIn && i < spliceBegin + fade) {
+            w = 0.5f - 0.5f * std::cos(static_cast<float>(M_PI) * (i - spliceBegin + 0.5f) / fade);
+        }
+        if (fadeOut && i + fade >= spliceEnd) {
+            w = std::min(w, 0.5f - 0.5f * std::cos(static_cast<float>(M_PI) * (spliceEnd - i - 0.5f) / fade));
+        }
+        dst[i] = previous[i] * (1.0f - w) + audio[i - windowStartSample] * w;
+    }
+
+    // Step 5: output rate. Only output samples whose filter span reaches the
+    // spliced range change; they are recomputed from a segment that covers
+    // their whole span, so the result equals resampling everything.
+    std::shared_ptr<const std::vector<float>> output = reconstruction;
+    if (params.sampleRate != plan.outputRate) {
+        Resampler resampler(params.sampleRate, plan.outputRate);
+        const int64_t inputRate = params.sampleRate;
+        const int64_t outputRate = plan.outputRate;
+        const int64_t taps = resampler.getTapsPerPhase();
+        const int64_t length = static_cast<int64_t>(renderLength);
+        // Segment starts fall on input samples aligned with an output sample
+        const int64_t alignment = inputRate / std::gcd(inputRate, outputRate);
+
+        const int64_t changedBegin = std::max<int64_t>(0, static_cast<int64_t>(spliceBegin) - taps);
+        const int64_t changedEnd = std::min(length, static_cast<int64_t>(spliceEnd) + taps);
+        const int64_t segmentBegin = std::max<int64_t>(0, changedBegin - taps) / alignment * alignment;
+        const int64_t segmentEnd = std::min(length, changedEnd + taps);
+
+        const std::vector<float> segmentIn(reconstruction->begin() + segmentBegin,
+                                           reconstruction->begin() + segmentEnd);
+        const std::vector<float> segmentOut = resampler.resample(segmentIn);
+
+        auto patched = std::make_shared<std::vector<float>>(*base.audio);
+        const int64_t segmentOffset = segmentBegin * outputRate / inputRate;
+        const int64_t j0 = changedBegin * outputRate / inputRate;
+        const int64_t j1 = std::min({
+            (changedEnd * outputRate + inputRate - 1) / inputRate,
+            static_cast<int64_t>(patched->size()),
+            segmentOffset + static_cast<int64_t>(segmentOut.size())});
+        for (int64_t j = j0; j < j1; ++j) {
+            (*patched)[j] = segmentOut[j - segmentOffset];
+        }
+        output = std::move(patched);
+    }
+
+    result.magnitude = std::move(magnitude);
+    result.reconstruction = std::move(reconstruction);
+    result.audio = std::move(output);
+    return true;
+}
+
+} // namespace img2spec
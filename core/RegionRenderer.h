@@ -0,0 +1,53 @@
+#pragma once
+
+#include "core/GrayscalePlane.h"
+#include "core/RenderPipeline.h"
+#include <atomic>
+#include <string>
+
+namespace img2spec {
+
+/**
+ * Patches a previous in-memory render after an edit to a few image columns
+ * instead of rendering the whole signal again.
+ *
+ * - Only the magnitude frames fed by the changed columns are rebuilt
+ * - Griffin-Lim runs on those frames plus margins on both sides. Every frame
+ *   starts from the phase of the previous render (an STFT of its
+ *   reconstruction); margin frames keep it, so the new audio lines up with
+ *   the untouched signal
+ * - The window is crossfaded into a copy of the previous reconstruction
+ *   inside the margins, and only the output-rate samples whose resampler
+ *   input changed are recomputed
+ *
+ * Cost scales with the edited width, not with the duration.
+ */
+class RegionRenderer {
+public:
+    explicit RegionRenderer(const RenderSettings& settings);
+
+    // Columns [begin, end) in which before and after differ. False when they
+    // are identical or not comparable (size or pixel format differs).
+    static bool findChangedColumns(const GrayscalePlane& before, const GrayscalePlane& after,
+                                   int* begin, int* end);
+
+    // base: full render, with these settings, of an image that matches image
+    // outside columns [columnBegin, columnEnd). result receives new stages
+    // for image; base is left untouched.
+    // progressCallback receives Griffin-Lim iterations (current, total).
+    bool render(
+        const GrayscalePlane& image,
+        int columnBegin,
+        int columnEnd,
+        const RenderStages& base,
+        RenderStages& result,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool>* cancelFlag = nullptr,
+        std::string* errorMessage = nullptr
+    );
+
+private:
+    const RenderSettings settings_;
+};
+
+} // namespace img2spec
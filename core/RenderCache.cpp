@@ -0,0 +1,193 @@
+#include "core/RenderCache.h"
+#include "core/Hash.h"
+
+namespace img2spec {
+
+RenderCache::Keys RenderCache::makeKeys(const GrayscalePlane& image, const RenderSettings& settings) {
+    uint64_t imageHash;
+    bool known;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        known = isCurrentImageLocked(image);
+        imageHash = imageHash_;
+    }
+    if (!known) {
+        // Hash outside the lock, the UI thread may be asking canPatch()
+        uint64_t h = hashBytes(image.data(), image.getSizeBytes());
+        h = hashValue(h, image.getWidth());
+        h = hashValue(h, image.getHeight());
+        imageHash = hashValue(h, image.getFormat());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!isCurrentImageLocked(image)) {
+            if (imageHash != imageHash_) {
+                previousImage_ = image_;
+                previousImageHash_ = imageHash_;
+            }
+            image_ = image;
+            imageHash_ = imageHash;
+        }
+    }
+    return chainKeys(imageHash, image.getWidth(), settings);
+}
+
+RenderCache::Keys RenderCache::chainKeys(uint64_t imageHash, int imageWidth, const RenderSettings& settings) {
+    const RenderPlan plan = planRender(settings, imageWidth);
+    const SpectrogramParams& spec = plan.params;
+    Keys keys;
+
+    uint64_t h = imageHash;
+    h = hashValue(h, spec.fftSize);
+    h = hashValue(h, spec.hopSize);
+    h = hashValue(h, spec.sampleRate);
+    h = hashValue(h, spec.freqScale);
+    h = hashValue(h, spec.minFreqHz);
+    h = hashValue(h, spec.maxFreqHz);
+    h = hashValue(h, spec.minDb);
+    h = hashValue(h, spec.gamma);
+    h = hashValue(h, plan.numFrames);
+    keys.magnitude = h;
+
+    h = hashValue(h, settings.iterations);
+    keys.reconstruction = h;
+
+    h = hashValue(h, plan.outputRate);
+    keys.audio = h;
+
+    const PostProcessSettings& post = settings.postProcess;
+    // Output stays mono; the channel count only enters the loudness measurement
+    h = hashValue(h, post.normalizeMode);
+    if (post.normalizeMode == NormalizeMode::Loudness) {
+        h = hashValue(h, post.normalizeTargetLufs);
+        h = hashValue(h, post.outputChannels);
+    } else {
+        h = hashValue(h, post.normalizeTargetDbfs);
+    }
+    h = hashValue(h, post.outputGainDb);
+    h = hashValue(h, post.safetyLimiter);
+    h = hashValue(h, post.limiterThreshold);
+    h = hashValue(h, post.truePeak);
+    h = hashValue(h, post.sampleRate);
+    h = hashValue(h, post.lookAheadMs);
+    h = hashValue(h, post.releaseMs);
+    keys.output = h;
+
+    return keys;
+}
+
+bool RenderCache::isCurrentImage(const GrayscalePlane& image) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return isCurrentImageLocked(image);
+}
+
+bool RenderCache::isCurrentImageLocked(const GrayscalePlane& image) const {
+    // image_ keeps its pixels alive, so an equal address means the same pixels
+    return !image_.isEmpty() && image_.data() == image.data()
+        && image_.getWidth() == image.getWidth() && image_.getHeight() == image.getHeight()
+        && image_.getFormat() == image.getFormat();
+}
+
+bool RenderCache::canPatch(const GrayscalePlane& image, const RenderSettings& settings,
+                           GrayscalePlane* renderedImage) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (image_.isEmpty() || isCurrentImageLocked(image)
+        || image_.getWidth() != image.getWidth() || image_.getHeight() != image.getHeight()
+        || image_.getFormat() != image.getFormat()
+        || !hasStagesLocked(chainKeys(imageHash_, image_.getWidth(), settings))) {
+        return false;
+    }
+    *renderedImage = image_;
+    return true;
+}
+
+bool RenderCache::findPreviousRender(const RenderSettings& settings, GrayscalePlane* previousImage,
+                                     RenderStages* stages) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (previousImage_.isEmpty()) {
+        return false;
+    }
+    const Keys keys = chainKeys(previousImageHash_, previousImage_.getWidth(), settings);
+    if (!hasStagesLocked(keys)) {
+        return false;
+    }
+    *previousImage = previousImage_;
+    stages->magnitude = magnitude_.value;
+    stages->reconstruction = reconstruction_.value;
+    stages->audio = audio_.value;
+    return true;
+}
+
+bool RenderCache::hasStagesLocked(const Keys& keys) const {
+    return find(magnitude_, keys.magnitude) && find(reconstruction_, keys.reconstruction)
+        && find(audio_, keys.audio);
+}
+
+std::shared_ptr<const RenderCache::Magnitude> RenderCache::findMagnitude(uint64_t key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return find(magnitude_, key);
+}
+
+std::shared_ptr<const RenderCache::Audio> RenderCache::findReconstruction(uint64_t key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return find(reconstruction_, key);
+}
+
+std::shared_ptr<const RenderCache::Audio> RenderCache::findAudio(uint64_t key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return find(audio_, key);
+}
+
+std::shared_ptr<const RenderCache::Audio> RenderCache::findOutput(uint64_t key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return find(output_, key);
+}
+
+void RenderCache::storeMagnitude(uint64_t key, std::shared_ptr<const Magnitude> magnitude) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    magnitude_ = {key, std::move(magnitude)};
+}
+
+void RenderCache::storeReconstruction(uint64_t key, std::shared_ptr<const Audio> reconstruction) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reconstruction_ = {key, std::move(reconstruction)};
+}
+
+void RenderCache::storeAudio(uint64_t key, std::shared_ptr<const Audio> audio) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    audio_ = {key, std::move(audio)};
+}
+
+void RenderCache::storeOutput(uint64_t key, std::shared_ptr<const Audio> output) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    output_ = {key, std::move(output)};
+}
+
+void RenderCache::dropStale(const Keys& keys) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (magnitude_.key != keys.magnitude) {
+        magnitude_ = {};
+    }
+    if (reconstruction_.key != keys.reconstruction) {
+        reconstruction_ = {};
+    }
+    if (audio_.key != keys.audio) {
+        audio_ = {};
+    }
+    if (output_.key != keys.output) {
+        output_ = {};
+    }
+}
+
+void RenderCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    image_ = GrayscalePlane();
+    imageHash_ = 0;
+    previousImage_ = GrayscalePlane();
+    previousImageHash_ = 0;
+    magnitude_ = {};
+    reconstruction_ = {};
+    audio_ = {};
+    output_ = {};
+}
+
+} // namespace img2spec
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "core/GrayscalePlane.h"
+#include "core/RenderPipeline.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace img2spec {
+
+/**
+ * Intermediate results of the last in-memory render, reused when only
+ * downstream parameters change.
+ *
+ *   magnitude       <- image, spectrogram parameters, frame count
+ *   reconstruction  <- magnitude, iterations (Griffin-Lim at the render rate)
+ *   audio           <- reconstruction, output rate (resampling)
+ *   output          <- audio, post-processing settings
+ *
+ * Each stage key chains the upstream key with the parameters the stage
+ * reads, so a parameter change invalidates exactly the stages after it:
+ * leveling-only changes skip the reconstruction, and an export following a
+ * preview with the same settings reuses the output. One entry per stage;
+ * results are shared, never copied. Thread-safe.
+ *
+ * The image seen before the current one is kept too: after an edit its
+ * stages are the base a RegionRenderer patches.
+ */
+class RenderCache {
+public:
+    using Magnitude = RenderStages::Magnitude;
+    using Audio = std::vector<float>;
+
+    struct Keys {
+        uint64_t magnitude = 0;
+        uint64_t reconstruction = 0;
+        uint64_t audio = 0;
+        uint64_t output = 0;
+    };
+
+    // Keys for rendering image with settings. The pixel hash is memoized
+    // for the last image seen (kept alive so its address stays unique).
+    Keys makeKeys(const GrayscalePlane& image, const RenderSettings& settings);
+
+    // True when image is the memoized one, i.e. makeKeys() will not hash pixels
+    bool isCurrentImage(const GrayscalePlane& image) const;
+
+    // True when image is new, has the shape of the current image and the
+    // current image has all stages for settings, i.e. a region re-render
+    // applies if the two differ in a few columns. renderedImage receives the
+    // current image for that comparison. Does not hash pixels.
+    bool canPatch(const GrayscalePlane& image, const RenderSettings& settings,
+                  GrayscalePlane* renderedImage) const;
+
+    // Stages rendered with settings for the image before the current one
+    // (after makeKeys() of the current one). False if any stage is missing.
+    bool findPreviousRender(const RenderSettings& settings, GrayscalePlane* previousImage,
+                            RenderStages* stages) const;
+
+    std::shared_ptr<const Magnitude> findMagnitude(uint64_t key) const;
+    std::shared_ptr<const Audio> findReconstruction(uint64_t key) const;
+    std::shared_ptr<const Audio> findAudio(uint64_t key) const;
+    std::shared_ptr<const Audio> findOutput(uint64_t key) const;
+
+    void storeMagnitude(uint64_t key, std::shared_ptr<const Magnitude> magnitude);
+    void storeReconstruction(uint64_t key, std::shared_ptr<const Audio> reconstruction);
+    void storeAudio(uint64_t key, std::shared_ptr<const Audio> audio);
+    void storeOutput(uint64_t key, std::shared_ptr<const Audio> output);
+
+    // Drop the stages keys will not reuse. Called before an in-memory render
+    // allocates new stages, so the replaced ones are not held alongside them.
+    void dropStale(const Keys& keys);
+
+    void clear();
+
+private:
+    template <typename T>
+    struct Entry {
+        uint64_t key = 0;
+        std::shared_ptr<const T> value;
+    };
+
+    template <typename T>
+    static std::shared_ptr<const T> find(const Entry<T>& entry, uint64_t key) {
+        return (entry.value && entry.key == key) ? entry.value : nullptr;
+    }
+
+    static Keys chainKeys(uint64_t imageHash, int imageWidth, const RenderSettings& settings);
+    bool isCurrentImageLocked(const GrayscalePlane& image) const;
+    bool hasStagesLocked(const Keys& keys) const;
+
+    mutable std::mutex mutex_;
+    GrayscalePlane image_;
+    uint64_t imageHash_ = 0;
+    GrayscalePlane previousImage_;
+    uint64_t previousImageHash_ = 0;
+    Entry<Magnitude> magnitude_;
+    Entry<Audio> reconstruction_;
+    Entry<Audio> audio_;
+    Entry<Audio> output_;
+};
+
+} // namespace img2spec
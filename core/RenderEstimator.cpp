@@ -0,0 +1,95 @@
+#include "core/RenderEstimator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace img2spec {
+
+namespace {
+
+// Per-element costs of the buffers held during a Griffin-Lim iteration
+constexpr double kBytesPerBin = sizeof(float)        // magnitude
+                              + sizeof(float)        // phase
+                              + 2 * 2 * sizeof(float); // complex spectrum + projected spectrum
+constexpr double kBytesPerRow = 3 * 40.0;            // std::vector headers + allocator overhead
+
+// Streaming-only buffers: spill read/write chunks, and the async writer
+// queue (per channel) when the disk falls behind
+constexpr double kSpillBytes = 2 * 65536 * sizeof(float);
+constexpr double kWriterQueueBytesPerChannel = 32 * 8192 * sizeof(float);
+
+// Timing constants (single core)
+constexpr double kFftSecondsPerUnit = 0.5e-9; // per N log2 N of a real FFT
+constexpr double kBinSeconds = 15e-9;         // polar + arg per bin and iteration
+constexpr double kSampleSeconds = 10e-9;      // resampling and post-processing per output sample
+
+} // namespace
+
+RenderEstimate RenderEstimator::estimate(const RenderSettings& settings, int imageWidth, int imageHeight) {
+    RenderEstimate result;
+    result.plan = planRender(settings, imageWidth);
+    const RenderPlan& plan = result.plan;
+    if (plan.numFrames <= 0 || imageHeight <= 0 || plan.outputRate <= 0) {
+        return result;
+    }
+
+    const double fftSize = plan.params.fftSize;
+    const double hopSize = plan.params.hopSize;
+    const double numBins = fftSize / 2 + 1;
+    const double frames = plan.numFrames;
+    const double renderSamples = static_cast<double>(plan.renderSamples);
+    const double outputSamples = static_cast<double>(plan.outputSamples);
+    const bool resampled = (plan.params.sampleRate != plan.outputRate);
+
+    result.durationSec = outputSamples / plan.outputRate;
+
+    // In memory: Griffin-Lim over every frame, signal plus window sum during
+    // the inverse STFT; stretching to a target duration keeps the source
+    // spectrogram alive while the stretched copy is built
+    const double griffinLim = frames * (numBins * kBytesPerBin + kBytesPerRow)
+                            + 2.0 * renderSamples * sizeof(float);
+    const double stretch = (plan.numFrames != plan.numSourceFrames)
+        ? plan.numSourceFrames * (numBins * sizeof(float) + kBytesPerRow)
+        : 0.0;
+    const double resample = resampled
+        ? frames * numBins * sizeof(float) + (renderSamples + outputSamples) * sizeof(float)
+        : 0.0;
+    result.inMemoryBytes = static_cast<size_t>(std::max(griffinLim + stretch, resample));
+
+    // Streaming: one window of blockFrames plus margins, each margin at
+    // least one frame long (see StreamingRenderer::render)
+    const int margin = std::max(settings.marginFrames,
+                                (plan.params.fftSize + plan.params.hopSize - 1) / plan.params.hopSize);
+    const double windowFrames = std::min<double>(frames, std::max(1, settings.blockFrames) + 2.0 * margin);
+    const double windowSamples = fftSize + (windowFrames - 1) * hopSize;
+    result.streamingBytes = static_cast<size_t>(
+        windowFrames * (numBins * (kBytesPerBin + 2 * sizeof(float)) + kBytesPerRow)
+        + 3.0 * windowSamples * sizeof(float)
+        + kSpillBytes
+        + kWriterQueueBytesPerChannel * std::max(1, settings.channels));
+
+    const double perFrame = 2.0 * kFftSecondsPerUnit * fftSize * std::log2(fftSize) + kBinSeconds * numBins;
+    result.cpuSeconds = std::max(1, settings.iterations + 1) * frames * perFrame
+                      + outputSamples * settings.channels * kSampleSeconds;
+    return result;
+}
+
+bool RenderEstimator::shouldStream(const RenderEstimate& estimate, size_t memoryBudgetBytes) {
+    return memoryBudgetBytes > 0 && estimate.inMemoryBytes > memoryBudgetBytes;
+}
+
+std::string RenderEstimator::formatBytes(size_t bytes) {
+    static const char* const kUnits[] = {"B", "KB", "MB", "GB", "TB"};
+    double value = static_cast<double>(bytes);
+    int unit = 0;
+    while (value >= 1024.0 && unit < 4) {
+        value /= 1024.0;
+        ++unit;
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), (unit == 0 || value >= 100.0) ? "%.0f %s" : "%.1f %s", value, kUnits[unit]);
+    return text;
+}
+
+} // namespace img2spec
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "core/RenderPipeline.h"
+#include <cstddef>
+#include <string>
+
+namespace img2spec {
+
+struct RenderEstimate {
+    RenderPlan plan;
+    double durationSec = 0.0;
+
+    // Predicted peak working memory in bytes (on top of the loaded image)
+    size_t inMemoryBytes = 0;   // whole-signal path (magnitude + Griffin-Lim state for all frames)
+    size_t streamingBytes = 0;  // StreamingRenderer (one window at a time)
+
+    // Rough single-core processing time, dominated by Griffin-Lim FFTs
+    double cpuSeconds = 0.0;
+};
+
+/**
+ * Cost model for a render, evaluated without touching any sample data.
+ *
+ * Memory follows the buffers the pipeline actually allocates: per-frame
+ * magnitude, phase and two complex spectra during a Griffin-Lim iteration,
+ * the overlap-add and window-sum signals, and the resampled output. CPU time
+ * counts one forward and one inverse real FFT plus the per-bin polar/arg
+ * work per frame and iteration, with constants measured on a desktop core.
+ */
+class RenderEstimator {
+public:
+    static RenderEstimate estimate(const RenderSettings& settings, int imageWidth, int imageHeight);
+
+    // True when the in-memory path is predicted to exceed memoryBudgetBytes
+    static bool shouldStream(const RenderEstimate& estimate, size_t memoryBudgetBytes);
+
+    // "512 KB", "1.2 GB", ...
+    static std::string formatBytes(size_t bytes);
+};
+
+} // namespace img2spec
@@ -0,0 +1,411 @@
+#include "core/RenderPipeline.h"
+#include "core/Resampler.h"
+#include "core/Stft.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace img2spec {
+
+namespace {
+
+constexpr size_t kSpillChunk = 65536;
+constexpr int kAnalysisPermille = 900; // pass 1 share of the progress range
+
+using FilePtr = std::unique_ptr<std::FILE, int (*)(std::FILE*)>;
+
+} // namespace
+
+RenderPlan planRender(const RenderSettings& settings, int imageWidth) {
+    RenderPlan plan;
+    plan.params = settings.spectrogram;
+    plan.outputRate = settings.spectrogram.sampleRate;
+    plan.numSourceFrames = std::max(0, imageWidth);
+    plan.numFrames = plan.numSourceFrames;
+
+    const SpectrogramParams& out = settings.spectrogram;
+    int renderRate = (out.freqScale == FrequencyScale::Linear)
+        ? out.sampleRate
+        : Resampler::chooseRenderRate(out.sampleRate, out.maxFreqHz, out.fftSize, out.hopSize);
+    if (out.freqScale != FrequencyScale::Linear) {
+        for (int d = settings.renderRateDivisor; d > 1; d /= 2) {
+            const int factor = 2 * (out.sampleRate / renderRate);
+            if (out.sampleRate % factor != 0 || out.fftSize % factor != 0 || out.hopSize % factor != 0) {
+                break;
+            }
+            renderRate /= 2;
+        }
+    }
+    const int renderFactor = out.sampleRate / renderRate;
+    plan.params.sampleRate = renderRate;
+    plan.params.fftSize = out.fftSize / renderFactor;
+    plan.params.hopSize = out.hopSize / renderFactor;
+
+    if (settings.targetDurationSec > 0.0) {
+        const int targetNumFrames = static_cast<int>(
+            std::round(settings.targetDurationSec * renderRate / plan.params.hopSize));
+        if (targetNumFrames > 0) {
+            plan.numFrames = targetNumFrames;
+        }
+    }
+
+    if (plan.numFrames > 0) {
+        plan.renderSamples = static_cast<size_t>(plan.params.fftSize)
+            + static_cast<size_t>(plan.numFrames - 1) * plan.params.hopSize;
+    }
+    plan.outputSamples = (plan.renderSamples * plan.outputRate + renderRate - 1) / renderRate;
+    return plan;
+}
+
+FrameSource::FrameSource(const GrayscalePlane& image, const RenderPlan& plan)
+    : numFrames_(plan.numFrames)
+    , numSourceFrames_(plan.numSourceFrames)
+{
+    builder_.prepare(image, plan.params);
+}
+
+void FrameSource::build(int t0, int t1, std::vector<float>& out) {
+    const int numBins = builder_.getNumBins();
+    out.resize(static_cast<size_t>(t1 - t0) * numBins);
+    if (numFrames_ == numSourceFrames_) {
+        builder_.buildFrames(t0, t1, out.data());
+        return;
+    }
+    auto sourceIndex = [this](int t) {
+        return (numFrames_ == 1) ? 0.0 : (t * (numSourceFrames_ - 1.0) / (numFrames_ - 1.0));
+    };
+    const int s0 = std::min(static_cast<int>(sourceIndex(t0)), numSourceFrames_ - 1);
+    const int s1 = std::min(static_cast<int>(sourceIndex(t1 - 1)) + 1, numSourceFrames_ - 1);
+    sourceFrames_.resize(static_cast<size_t>(s1 - s0 + 1) * numBins);
+    builder_.buildFrames(s0, s1 + 1, sourceFrames_.data());
+    for (int t = t0; t < t1; ++t) {
+        const double srcIdx = sourceIndex(t);
+        const int i0 = std::min(static_cast<int>(srcIdx), numSourceFrames_ - 1);
+        const int i1 = std::min(i0 + 1, numSourceFrames_ - 1);
+        const float frac = static_cast<float>(srcIdx - i0);
+        const float* row0 = sourceFrames_.data() + static_cast<size_t>(i0 - s0) * numBins;
+        const float* row1 = sourceFrames_.data() + static_cast<size_t>(i1 - s0) * numBins;
+        float* dst = out.data() + static_cast<size_t>(t - t0) * numBins;
+        for (int k = 0; k < numBins; ++k) {
+            dst[k] = row0[k] * (1.0f - frac) + row1[k] * frac;
+        }
+    }
+}
+
+RenderStages::Magnitude buildMagnitude(const GrayscalePlane& image, const RenderPlan& plan) {
+    // Generate in blocks so each image row is read contiguously
+    constexpr int kBlockFrames = 64;
+    FrameSource source(image, plan);
+    const int numBins = source.getNumBins();
+    RenderStages::Magnitude magnitude(static_cast<size_t>(std::max(0, plan.numFrames)));
+    std::vector<float> block;
+    for (int t0 = 0; t0 < plan.numFrames; t0 += kBlockFrames) {
+        const int t1 = std::min(t0 + kBlockFrames, plan.numFrames);
+        source.build(t0, t1, block);
+        for (int t = t0; t < t1; ++t) {
+            const float* frame = block.data() + static_cast<size_t>(t - t0) * numBins;
+            magnitude[t].assign(frame, frame + numBins);
+        }
+    }
+    return magnitude;
+}
+
+RenderSettings makeDraftSettings(const RenderSettings& settings, int imageWidth, const DraftOptions& options) {
+    RenderSettings draft = settings;
+    draft.iterations = std::max(std::min(settings.iterations, 4),
+                                settings.iterations / std::max(1, options.iterationDivisor));
+    draft.renderRateDivisor = std::max(1, options.rateDivisor);
+
+    SpectrogramParams& spec = draft.spectrogram;
+    const int hopSize = spec.hopSize * std::max(1, options.hopMultiplier);
+    if (hopSize != spec.hopSize && hopSize <= spec.fftSize / 2) {
+        // Fewer, wider-spaced frames over the same time span: pin the duration
+        // so the image is stretched onto the coarser frame grid
+        if (draft.targetDurationSec <= 0.0) {
+            const RenderPlan plan = planRender(settings, imageWidth);
+            draft.targetDurationSec = static_cast<double>(plan.numFrames) * plan.params.hopSize
+                                      / plan.params.sampleRate;
+        }
+        spec.hopSize = hopSize;
+    }
+    return draft;
+}
+
+StreamingRenderer::StreamingRenderer(const RenderSettings& settings)
+    : settings_(settings)
+{
+}
+
+bool StreamingRenderer::renderBlocks(
+    const GrayscalePlane& image,
+    const BlockCallback& blockCallback,
+    ProgressCallback progressCallback,
+    const std::atomic<bool>* cancelFlag,
+    std::string* errorMessage
+) {
+    auto fail = [&](const std::string& message) {
+        std::cerr << "StreamingRenderer: " << message << std::endl;
+        if (errorMessage) {
+            *errorMessage = message;
+        }
+        return false;
+    };
+    auto cancelled = [cancelFlag]() { return cancelFlag && cancelFlag->load(std::memory_order_relaxed); };
+
+    if (image.isEmpty()) {
+        return fail("No image data");
+    }
+
+    const RenderPlan plan = planRender(settings_, image.getWidth());
+    const SpectrogramParams& params = plan.params;
+    const int numFrames = plan.numFrames;
+    const int fftSize = params.fftSize;
+    const int hopSize = params.hopSize;
+    if (numFrames <= 0 || fftSize <= 0 || hopSize <= 0) {
+        return fail("Invalid render parameters");
+    }
+
+    // Margins must cover one full frame so committed samples never see the
+    // window edges, where fewer frames overlap
+    const int blockFrames = std::max(1, settings_.blockFrames);
+    const int firstBlockFrames = (settings_.firstBlockFrames > 0)
+        ? std::min(settings_.firstBlockFrames, blockFrames)
+        : blockFrames;
+    const int marginFrames = std::max(settings_.marginFrames, (fftSize + hopSize - 1) / hopSize);
+
+    std::cout << "StreamingRenderer: " << numFrames << " frames at " << params.sampleRate << " Hz"
+              << " (FFT " << fftSize << ", hop " << hopSize << "), blocks of "
+              << blockFrames << " + 2 x " << marginFrames << " frames" << std::endl;
+
+    FrameSource frameSource(image, plan);
+    const int numBins = frameSource.getNumBins();
+
+    Stft stft(fftSize, hopSize);
+    stft.setVerbose(false);
+    GriffinLim griffinLim;
+
+    std::unique_ptr<Resampler> resampler;
+    if (params.sampleRate != plan.outputRate) {
+        resampler = std::make_unique<Resampler>(params.sampleRate, plan.outputRate);
+    }
+
+    auto emit = [&](const float* samples, size_t count) {
+        return count == 0 || blockCallback(samples, count);
+    };
+
+    std::vector<float> magnitudes;
+    std::vector<const float*> framePointers;
+    std::vector<std::vector<float>> previousPhase;
+    int previousStart = 0;
+    std::vector<float> previousTail; // previous window's take on the next block's first samples
+    std::vector<float> resampled;
+
+    // Blocks start at firstBlockFrames and double up to blockFrames, so the
+    // first output arrives quickly and later blocks amortize their margins
+    int currentBlockFrames = firstBlockFrames;
+    const int startFrame = std::min(std::max(0, settings_.startFrame), numFrames);
+    const int endFrame = (settings_.endFrame > 0) ? std::min(settings_.endFrame, numFrames) : numFrames;
+    for (int s = startFrame, commitEnd = startFrame; s < endFrame; s = commitEnd) {
+        if (cancelled()) {
+            return fail("Cancelled");
+        }
+
+        commitEnd = std::min(endFrame, s + currentBlockFrames);
+        currentBlockFrames = std::min(blockFrames, 2 * currentBlockFrames);
+        const int windowStart = std::max(0, s - marginFrames);
+        const int windowEnd = std::min(numFrames, commitEnd + marginFrames);
+        const int windowFrames = windowEnd - windowStart;
+
+        frameSource.build(windowStart, windowEnd, magnitudes);
+        framePointers.resize(windowFrames);
+        for (int t = 0; t < windowFrames; ++t) {
+            framePointers[t] = magnitudes.data() + static_cast<size_t>(t) * numBins;
+        }
+
+        // Frames before s are locked to the committed phase, the look-ahead
+        // margin of the previous window warm-starts the frames after it.
+        // A run starting mid-signal has no committed phase: its leading
+        // margin is free context.
+        std::vector<std::vector<float>> phase(windowFrames);
+        for (int t = windowStart; t < windowEnd; ++t) {
+            const int prev = t - previousStart;
+            if (prev >= 0 && prev < static_cast<int>(previousPhase.size())) {
+                phase[t - windowStart] = std::move(previousPhase[prev]);
+            }
+        }
+
+        std::vector<float> audio = griffinLim.reconstructWindow(
+            framePointers, numBins, stft, settings_.iterations, phase,
+            previousPhase.empty() ? 0 : s - windowStart, cancelFlag);
+        if (cancelled()) {
+            return fail("Cancelled");
+        }
+
+        const size_t offset = static_cast<size_t>(s - windowStart) * hopSize;
+        const size_t end = (commitEnd == numFrames)
+            ? plan.renderSamples - static_cast<size_t>(windowStart) * hopSize
+            : static_cast<size_t>(commitEnd - windowStart) * hopSize;
+        if (audio.size() < end) {
+            return fail("Griffin-Lim reconstruction failed");
+        }
+        float* chunk = audio.data() + offset;
+        const size_t chunkSize = end - offset;
+
+        const size_t fade = std::min(previousTail.size(), chunkSize);
+        for (size_t i = 0; i < fade; ++i) {
+            const float w = 0.5f - 0.5f * std::cos(static_cast<float>(M_PI) * (i + 0.5f) / fade);
+            chunk[i] = previousTail[i] * (1.0f - w) + chunk[i] * w;
+        }
+
+        const size_t tailSize = std::min(static_cast<size_t>(marginFrames) * hopSize,
+                                         static_cast<size_t>(fftSize));
+        previousTail.assign(audio.begin() + std::min(audio.size(), end),
+                            audio.begin() + std::min(audio.size(), end + tailSize));
+        previousPhase = std::move(phase);
+        previousStart = windowStart;
+
+        bool ok;
+        if (resampler) {
+            resampled.clear();
+            resampler->process(chunk, chunkSize, resampled);
+            ok = emit(resampled.data(), resampled.size());
+        } else {
+            ok = emit(chunk, chunkSize);
+        }
+        if (!ok) {
+            return fail("Block output failed");
+        }
+
+        if (progressCallback) {
+            progressCallback(commitEnd - startFrame, endFrame - startFrame);
+        }
+    }
+
+    if (resampler) {
+        resampled.clear();
+        resampler->flush(resampled);
+        if (!emit(resampled.data(), resampled.size())) {
+            return fail("Block output failed");
+        }
+    }
+    return true;
+}
+
+bool StreamingRenderer::render(
+    const GrayscalePlane& image,
+    const std::string& outputPath,
+    ProgressCallback progressCallback,
+    const std::atomic<bool>* cancelFlag,
+    std::string* errorMessage
+) {
+    const std::string spillPath = outputPath + ".part";
+
+    auto fail = [&](const std::string& message) {
+        std::cerr << "StreamingRenderer: " << message << std::endl;
+        if (errorMessage) {
+            *errorMessage = message;
+        }
+        std::remove(spillPath.c_str());
+        return false;
+    };
+    auto cancelled = [cancelFlag]() { return cancelFlag && cancelFlag->load(std::memory_order_relaxed); };
+
+    const RenderPlan plan = planRender(settings_, image.getWidth());
+    PostProcessor postProcessor(settings_.postProcess);
+
+    FilePtr spill(std::fopen(spillPath.c_str(), "w+b"), &std::fclose);
+    if (!spill) {
+        return fail("Failed to create " + spillPath);
+    }
+
+    // Pass 1: reconstruct block by block, analyze and spill
+    size_t spilledSamples = 0;
+    bool spillFailed = false;
+    auto emit = [&](const float* samples, size_t count) {
+        postProcessor.analyze(samples, count);
+        spilledSamples += count;
+        spillFailed = std::fwrite(samples, sizeof(float), count, spill.get()) != count;
+        return !spillFailed;
+    };
+    auto pass1Progress = [&progressCallback](int current, int total) {
+        if (progressCallback) {
+            progressCallback(static_cast<int>(static_cast<int64_t>(current) * kAnalysisPermille / total), 1000);
+        }
+    };
+
+    std::string pass1Error;
+    if (!renderBlocks(image, emit, pass1Progress, cancelFlag, &pass1Error)) {
+        if (spillFailed) {
+            return fail("Failed to write " + spillPath);
+        }
+        // renderBlocks() has already logged the reason
+        if (errorMessage) {
+            *errorMessage = pass1Error;
+        }
+        std::remove(spillPath.c_str());
+        return false;
+    }
+    if (spilledSamples == 0) {
+        return fail("Rendered audio is empty");
+    }
+
+    postProcessor.finalizeAnalysis();
+    std::cout << "StreamingRenderer: " << spilledSamples << " samples, DC offset: "
+              << postProcessor.getMean() << ", peak: " << postProcessor.getPeak() << std::endl;
+
+    // Pass 2: post-process the spilled samples into the writer
+    WavWriter writer;
+    writer.setAsync(true);
+    writer.setDither(settings_.dither);
+    if (!writer.open(outputPath, settings_.channels, plan.outputRate, settings_.bitDepth, spilledSamples)) {
+        return fail("Failed to open " + outputPath);
+    }
+
+    std::rewind(spill.get());
+    std::vector<float> in(kSpillChunk);
+    std::vector<float> out(kSpillChunk + postProcessor.getLatency());
+    size_t remaining = spilledSamples;
+    while (remaining > 0) {
+        if (cancelled()) {
+            writer.finalize();
+            std::remove(outputPath.c_str());
+            return fail("Cancelled");
+        }
+
+        const size_t count = std::min(remaining, kSpillChunk);
+        if (std::fread(in.data(), sizeof(float), count, spill.get()) != count) {
+            writer.finalize();
+            return fail("Failed to read " + spillPath);
+        }
+        remaining -= count;
+
+        const size_t written = postProcessor.process(in.data(), count, out.data(), 1, remaining == 0);
+        if (!writer.append(AudioView::broadcast(out.data(), written, settings_.channels))) {
+            writer.finalize();
+            return fail("Failed to write " + outputPath);
+        }
+
+        if (progressCallback) {
+            const size_t done = spilledSamples - remaining;
+            progressCallback(kAnalysisPermille
+                + static_cast<int>(done * (1000 - kAnalysisPermille) / spilledSamples), 1000);
+        }
+    }
+
+    spill.reset();
+    std::remove(spillPath.c_str());
+
+    if (!writer.finalize()) {
+        return fail("Failed to finalize " + outputPath);
+    }
+
+    std::cout << "StreamingRenderer: Wrote " << writer.getFramesWritten() << " frames to "
+              << outputPath << std::endl;
+    return true;
+}
+
+} // namespace img2spec
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "core/GrayscalePlane.h"
+#include "core/GriffinLim.h"
+#include "core/Leveling.h"
+#include "core/Quantizer.h"
+#include "core/SpectrogramBuilder.h"
+#include "core/WavWriter.h"
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace img2spec {
+
+// Everything needed to turn an image into a WAV file, independent of the UI
+struct RenderSettings {
+    SpectrogramParams spectrogram;   // FFT/hop and sample rate at the output rate
+    int iterations = 64;
+    double targetDurationSec = 0.0;  // > 0: stretch the spectrogram to this duration
+    int channels = 1;                // mono render broadcast to this many channels
+    int renderRateDivisor = 1;       // > 1: render below the automatic internal rate (log scale
+                                     // only, content above the lower Nyquist is dropped)
+    BitDepth bitDepth = BitDepth::Int16;
+    DitherSettings dither;
+    PostProcessSettings postProcess;
+
+    // Streaming: Griffin-Lim runs on windows of blockFrames frames plus
+    // marginFrames of context on each side
+    int blockFrames = 256;
+    int marginFrames = 16;
+    // > 0: the first block has this many frames and block sizes double up to
+    // blockFrames, so the first audio is ready sooner (progressive preview)
+    int firstBlockFrames = 0;
+    // renderBlocks(): commit frames [startFrame, endFrame) only (seek
+    // playback); endFrame 0 means up to the last frame
+    int startFrame = 0;
+    int endFrame = 0;
+};
+
+// Derived render geometry
+struct RenderPlan {
+    SpectrogramParams params;  // at the internal render rate
+    int outputRate = 0;
+    int numSourceFrames = 0;   // image columns
+    int numFrames = 0;         // STFT frames after target-duration resampling
+    size_t renderSamples = 0;  // signal length at the render rate
+    size_t outputSamples = 0;  // signal length at the output rate (per channel)
+};
+
+// Log mode renders at the lowest rate that covers maxFreqHz (see
+// Resampler::chooseRenderRate); linear mode renders at the output rate
+RenderPlan planRender(const RenderSettings& settings, int imageWidth);
+
+// Magnitude frames of a render plan, pulled from the image on demand and
+// stretched to the target duration by linear interpolation between columns
+class FrameSource {
+public:
+    FrameSource(const GrayscalePlane& image, const RenderPlan& plan);
+
+    int getNumBins() const { return builder_.getNumBins(); }
+
+    // Frames [t0, t1) into out, frame-major ((t1 - t0) x numBins)
+    void build(int t0, int t1, std::vector<float>& out);
+
+private:
+    SpectrogramBuilder builder_;
+    int numFrames_;
+    int numSourceFrames_;
+    std::vector<float> sourceFrames_;
+};
+
+// Intermediate results of a whole-signal (in-memory) render
+struct RenderStages {
+    using Magnitude = std::vector<std::vector<float>>;
+
+    std::shared_ptr<const Magnitude> magnitude;               // plan.numFrames frames at the render rate
+    std::shared_ptr<const std::vector<float>> reconstruction; // Griffin-Lim output at the render rate
+    std::shared_ptr<const std::vector<float>> audio;          // reconstruction at the output rate
+};
+
+// All plan.numFrames magnitude frames at once (the in-memory path), through
+// FrameSource so they match streamed and region-rendered frames exactly
+RenderStages::Magnitude buildMagnitude(const GrayscalePlane& image, const RenderPlan& plan);
+
+// How much cheaper a draft preview is than the final render
+struct DraftOptions {
+    int iterationDivisor = 4;   // Griffin-Lim iterations / divisor (at least 4)
+    int hopMultiplier = 2;      // coarser hop; capped at 50% frame overlap
+    int rateDivisor = 1;        // see RenderSettings::renderRateDivisor
+};
+
+// Settings for a draft of settings: same output rate, channels and duration
+// (within one hop), a fraction of the reconstruction cost
+RenderSettings makeDraftSettings(const RenderSettings& settings, int imageWidth, const DraftOptions& options);
+
+// Receives consecutive chunks of reconstructed audio; return false to abort
+using BlockCallback = std::function<bool(const float* samples, size_t count)>;
+
+/**
+ * Bounded-memory render: image -> magnitude frames -> block-wise
+ * Griffin-Lim -> resampler -> post-processing -> WAV, one block at a time.
+ *
+ * Peak memory depends on the block size and FFT size, not on the duration:
+ * - Magnitude frames are pulled from the image per window
+ *   (SpectrogramBuilder::buildFrames), never materialized as a whole
+ * - Each window overlaps the previous one by marginFrames; those frames keep
+ *   the phase already committed and the next margin is warm-started from
+ *   the previous window, so blocks join without phase jumps. A short
+ *   raised-cosine crossfade hides what remains.
+ * - Normalization needs whole-signal statistics, so pass 1 analyzes and
+ *   spills raw samples next to the output file (<path>.part); pass 2 streams
+ *   them through PostProcessor::process() into the writer.
+ */
+class StreamingRenderer {
+public:
+    explicit StreamingRenderer(const RenderSettings& settings);
+
+    // Reconstruct block by block and hand each committed chunk, resampled to
+    // the output rate but not post-processed, to blockCallback (mono).
+    // With a startFrame the first chunk begins at that frame's first sample.
+    // progressCallback receives (committed frames, frames in the range).
+    bool renderBlocks(
+        const GrayscalePlane& image,
+        const BlockCallback& blockCallback,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool>* cancelFlag = nullptr,
+        std::string* errorMessage = nullptr
+    );
+
+    // progressCallback receives (current, total) in permille of the whole render
+    bool render(
+        const GrayscalePlane& image,
+        const std::string& outputPath,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool>* cancelFlag = nullptr,
+        std::string* errorMessage = nullptr
+    );
+
+private:
+    const RenderSettings settings_;
+};
+
+} // namespace img2spec
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+
+namespace img2spec {
+
+enum class RenderStage {
+    Idle,
+    Spectrogram,
+    GriffinLim,
+    Resampling,
+    PostProcessing,
+    Writing,
+    Done
+};
+
+/**
+ * Progress shared between a render worker and the UI.
+ *
+ * The worker publishes from its inner loops; the UI polls on a timer instead
+ * of being signalled. All fields are independent atomics, so publishing never
+ * blocks or touches the event loop, and unchanged values are not stored
+ * again (no cache-line traffic for the poller when nothing moved).
+ */
+class RenderProgress {
+public:
+    void reset() {
+        stage_.store(static_cast<int>(RenderStage::Idle), std::memory_order_relaxed);
+        permille_.store(0, std::memory_order_relaxed);
+        iteration_.store(0, std::memory_order_relaxed);
+        totalIterations_.store(0, std::memory_order_relaxed);
+    }
+
+    // Worker side
+    void setStage(RenderStage stage, int permille) {
+        stage_.store(static_cast<int>(stage), std::memory_order_relaxed);
+        setPermille(permille);
+    }
+
+    // Overall progress 0..1000; never moves backwards
+    void setPermille(int permille) {
+        if (permille > permille_.load(std::memory_order_relaxed)) {
+            permille_.store(permille, std::memory_order_relaxed);
+        }
+    }
+
+    void setIteration(int current, int total) {
+        if (iteration_.load(std::memory_order_relaxed) != current) {
+            totalIterations_.store(total, std::memory_order_relaxed);
+            iteration_.store(current, std::memory_order_relaxed);
+        }
+    }
+
+    // UI side
+    RenderStage getStage() const { return static_cast<RenderStage>(stage_.load(std::memory_order_relaxed)); }
+    int getPermille() const { return permille_.load(std::memory_order_relaxed); }
+    int getIteration() const { return iteration_.load(std::memory_order_relaxed); }
+    int getTotalIterations() const { return totalIterations_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int> stage_{static_cast<int>(RenderStage::Idle)};
+    std::atomic<int> permille_{0};
+    std::atomic<int> iteration_{0};
+    std::atomic<int> totalIterations_{0};
+};
+
+} // namespace img2spec
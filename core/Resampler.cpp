@@ -0,0 +1,210 @@
+#include "core/Resampler.h"
+#include "core/Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace img2spec {
+
+namespace {
+
+constexpr int kZeroCrossings = 16;   // per side, at the filter cutoff
+constexpr double kKaiserBeta = 8.0;  // ~80 dB stopband
+constexpr double kRolloff = 0.94;    // cutoff (-6 dB) relative to the lower Nyquist
+// Flat band of this design (within 0.01 dB up to 0.8; -0.27 dB at 0.85,
+// -2 dB at 0.9), relative to the lower Nyquist
+constexpr double kPassband = 0.8;
+constexpr double kPassbandToleranceDb = 0.05;
+
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    const double halfX = x * 0.5;
+    for (int k = 1; k < 32; ++k) {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+    }
+    return sum;
+}
+
+// Floor division for possibly negative numerators
+int64_t floorDiv(int64_t a, int64_t b) {
+    const int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+} // namespace
+
+Resampler::Resampler(int inputRate, int outputRate)
+    : inputRate_(inputRate)
+    , outputRate_(outputRate)
+{
+    const int g = std::gcd(inputRate, outputRate);
+    up_ = outputRate / g;
+    down_ = inputRate / g;
+
+    // Cutoff in units of the input Nyquist frequency
+    const double cutoff = kRolloff * std::min(1.0, static_cast<double>(up_) / down_);
+    const int halfTaps = static_cast<int>(std::ceil(kZeroCrossings / cutoff));
+    taps_ = 2 * halfTaps;
+
+    // Phase p covers fractional input offset p / L; tap t reads
+    // x[floor(tau) - (halfTaps - 1) + t]
+    const double pi = 3.14159265358979323846;
+    const double i0Beta = besselI0(kKaiserBeta);
+    phases_.resize(static_cast<size_t>(up_) * taps_);
+    for (int p = 0; p < up_; ++p) {
+        const double frac = static_cast<double>(p) / up_;
+        float* taps = &phases_[static_cast<size_t>(p) * taps_];
+        double sum = 0.0;
+        std::vector<double> h(taps_);
+        for (int t = 0; t < taps_; ++t) {
+            const double x = frac + (halfTaps - 1) - t; // distance in input samples
+            const double arg = pi * cutoff * x;
+            const double sinc = (std::abs(arg) < 1e-12) ? 1.0 : std::sin(arg) / arg;
+            const double r = x / halfTaps;
+            const double window = (std::abs(r) < 1.0)
+                ? besselI0(kKaiserBeta * std::sqrt(1.0 - r * r)) / i0Beta
+                : 0.0;
+            h[t] = cutoff * sinc * window;
+            sum += h[t];
+        }
+        // Unity DC gain per phase (no ripple at DC between phases)
+        for (int t = 0; t < taps_; ++t) {
+            taps[t] = static_cast<float>(h[t] / sum);
+        }
+    }
+
+    reset();
+}
+
+void Resampler::reset() {
+    // Virtual zeros before the first sample
+    history_.assign(taps_ / 2, 0.0f);
+    historyStart_ = -(taps_ / 2);
+    inputCount_ = 0;
+    outputCount_ = 0;
+}
+
+void Resampler::computeOutputs(const float* input, int64_t inputStart, int64_t j0, int64_t j1, float* out) const {
+    const int halfTaps = taps_ / 2;
+    for (int64_t j = j0; j < j1; ++j) {
+        const int64_t pos = j * down_;
+        const int64_t base = floorDiv(pos, up_);
+        const int phase = static_cast<int>(pos - base * up_);
+        const float* taps = &phases_[static_cast<size_t>(phase) * taps_];
+        const float* x = input + (base - (halfTaps - 1) - inputStart);
+        float acc = 0.0f;
+        for (int t = 0; t < taps_; ++t) {
+            acc += taps[t] * x[t];
+        }
+        out[j - j0] = acc;
+    }
+}
+
+int64_t Resampler::outputsAvailable(int64_t inputEnd) const {
+    // Output j needs input up to floor(j * M / L) + halfTaps (exclusive end)
+    const int64_t lastBase = inputEnd - taps_ / 2 - 1;
+    if (lastBase < 0) {
+        return 0;
+    }
+    return floorDiv(lastBase * up_ + up_ - 1, down_) + 1;
+}
+
+void Resampler::process(const float* in, size_t numSamples, std::vector<float>& out) {
+    history_.insert(history_.end(), in, in + numSamples);
+    inputCount_ += static_cast<int64_t>(numSamples);
+
+    const int64_t available = outputsAvailable(inputCount_);
+    if (available > outputCount_) {
+        const size_t offset = out.size();
+        out.resize(offset + static_cast<size_t>(available - outputCount_));
+        computeOutputs(history_.data(), historyStart_, outputCount_, available, out.data() + offset);
+        outputCount_ = available;
+    }
+
+    // Drop input no longer reachable by future outputs
+    const int64_t nextBase = floorDiv(outputCount_ * down_, up_);
+    const int64_t keepFrom = nextBase - (taps_ / 2 - 1);
+    if (keepFrom > historyStart_) {
+        const size_t drop = static_cast<size_t>(std::min<int64_t>(keepFrom - historyStart_,
+                                                                  static_cast<int64_t>(history_.size())));
+        history_.erase(history_.begin(), history_.begin() + drop);
+        historyStart_ += static_cast<int64_t>(drop);
+    }
+}
+
+void Resampler::flush(std::vector<float>& out) {
+    const int64_t total = (inputCount_ * up_ + down_ - 1) / down_;
+    const int64_t inputCount = inputCount_;
+    const std::vector<float> zeros(taps_, 0.0f);
+    process(zeros.data(), zeros.size(), out);
+
+    // Trim outputs computed from the padding beyond the real signal length
+    if (outputCount_ > total) {
+        out.resize(out.size() - static_cast<size_t>(outputCount_ - total));
+    }
+    inputCount_ = inputCount;
+    outputCount_ = total;
+}
+
+std::vector<float> Resampler::resample(const std::vector<float>& in) const {
+    const int64_t inputCount = static_cast<int64_t>(in.size());
+    const int64_t total = (inputCount * up_ + down_ - 1) / down_;
+
+    // Zero-padded copy so every output can read its full window
+    const int halfTaps = taps_ / 2;
+    std::vector<float> padded(in.size() + 2 * static_cast<size_t>(taps_), 0.0f);
+    std::copy(in.begin(), in.end(), padded.begin() + halfTaps);
+
+    std::vector<float> out(static_cast<size_t>(total));
+    constexpr int kBlock = 4096;
+    const int numBlocks = static_cast<int>((total + kBlock - 1) / kBlock);
+    parallelFor(0, numBlocks, [&](int b0, int b1) {
+        const int64_t j0 = static_cast<int64_t>(b0) * kBlock;
+        const int64_t j1 = std::min<int64_t>(total, static_cast<int64_t>(b1) * kBlock);
+        computeOutputs(padded.data(), -halfTaps, j0, j1, out.data() + j0);
+    });
+    return out;
+}
+
+double Resampler::getGainDb(double freqHz) const {
+    // Component at freqHz in the output: the mean of the phase responses
+    // (their differences go into images)
+    const double pi = 3.14159265358979323846;
+    const double omega = 2.0 * pi * freqHz / inputRate_;
+    const int halfTaps = taps_ / 2;
+    double re = 0.0;
+    double im = 0.0;
+    for (int p = 0; p < up_; ++p) {
+        const double frac = static_cast<double>(p) / up_;
+        const float* taps = &phases_[static_cast<size_t>(p) * taps_];
+        for (int t = 0; t < taps_; ++t) {
+            const double x = frac + (halfTaps - 1) - t;
+            re += taps[t] * std::cos(omega * x);
+            im -= taps[t] * std::sin(omega * x);
+        }
+    }
+    const double gain = std::sqrt(re * re + im * im) / up_;
+    return 20.0 * std::log10(std::max(gain, 1e-12));
+}
+
+int Resampler::chooseRenderRate(int outputRate, double maxFreqHz, int fftSize, int hopSize) {
+    int best = outputRate;
+    for (int k = 2; k <= 4; k *= 2) {
+        if (outputRate % k != 0 || fftSize % k != 0 || hopSize % k != 0) {
+            break;
+        }
+        const int rate = outputRate / k;
+        // Content must stay inside the resampler passband at the lower rate,
+        // where the interpolation filter is flat
+        if (maxFreqHz > 0.5 * rate * kPassband
+            || Resampler(rate, outputRate).getGainDb(maxFreqHz) < -kPassbandToleranceDb) {
+            break;
+        }
+        best = rate;
+    }
+    return best;
+}
+
+} // namespace img2spec
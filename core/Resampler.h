@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace img2spec {
+
+/**
+ * Rational polyphase resampler (outputRate / inputRate = L / M)
+ * - Kaiser-windowed sinc, cutoff just below the lower Nyquist frequency
+ * - One tap table per output phase; each output sample is a contiguous
+ *   dot product over the input, which the compiler vectorizes
+ * - Zero delay: output sample j is aligned with input time j * M / L
+ * - Chunked (process / flush) or whole-buffer (resample, multi-threaded)
+ */
+class Resampler {
+public:
+    Resampler(int inputRate, int outputRate);
+
+    int getInputRate() const { return inputRate_; }
+    int getOutputRate() const { return outputRate_; }
+    // Input samples each output sample is computed from (filter span)
+    int getTapsPerPhase() const { return taps_; }
+
+    /**
+     * Resample a chunk; output samples are appended to out.
+     * Chunks must be consecutive. Call flush() after the last chunk.
+     */
+    void process(const float* in, size_t numSamples, std::vector<float>& out);
+
+    /**
+     * Emit the remaining output (total output = ceil(input * L / M))
+     */
+    void flush(std::vector<float>& out);
+
+    void reset();
+
+    /**
+     * Whole-buffer conversion, parallel over output ranges
+     */
+    std::vector<float> resample(const std::vector<float>& in) const;
+
+    /**
+     * Filter response at freqHz (dB), for a sinusoid at the input rate
+     */
+    double getGainDb(double freqHz) const;
+
+    /**
+     * Lowest internal render rate outputRate / k (k in {1, 2, 4}, k must
+     * divide both fftSize and hopSize) whose resampler is still flat at
+     * maxFreqHz: the transition band lies between maxFreqHz and the lower
+     * Nyquist frequency
+     */
+    static int chooseRenderRate(int outputRate, double maxFreqHz, int fftSize, int hopSize);
+
+private:
+    void computeOutputs(const float* input, int64_t inputStart, int64_t j0, int64_t j1, float* out) const;
+    int64_t outputsAvailable(int64_t inputEnd) const;
+
+    int inputRate_;
+    int outputRate_;
+    int up_;    // L
+    int down_;  // M
+    int taps_;  // per phase (even)
+    std::vector<float> phases_; // up_ x taps_
+
+    // Streaming state
+    std::vector<float> history_;  // input samples from historyStart_
+    int64_t historyStart_ = 0;
+    int64_t inputCount_ = 0;
+    int64_t outputCount_ = 0;
+};
+
+} // namespace img2spec
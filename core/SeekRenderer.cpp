@@ -0,0 +1,255 @@
+#include "core/SeekRenderer.h"
+#include "core/Hash.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace img2spec {
+
+SegmentCache::SegmentCache(size_t maxBytes)
+    : maxBytes_(maxBytes)
+{
+}
+
+std::shared_ptr<const SegmentCache::Samples> SegmentCache::find(uint64_t key, int index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (key != key_) {
+        return nullptr;
+    }
+    auto it = segments_.find(index);
+    if (it == segments_.end()) {
+        return nullptr;
+    }
+    it->second.lastUse = ++useCounter_;
+    return it->second.samples;
+}
+
+void SegmentCache::store(uint64_t key, int index, std::shared_ptr<const Samples> samples) {
+    if (!samples) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (key != key_) {
+        segments_.clear();
+        bytes_ = 0;
+        key_ = key;
+    }
+
+    Entry& entry = segments_[index];
+    if (entry.samples) {
+        bytes_ -= entry.samples->size() * sizeof(float);
+    }
+    bytes_ += samples->size() * sizeof(float);
+    entry.samples = std::move(samples);
+    entry.lastUse = ++useCounter_;
+
+    // The segment just stored is the most recent one and stays
+    while (bytes_ > maxBytes_ && segments_.size() > 1) {
+        auto oldest = std::min_element(segments_.begin(), segments_.end(),
+            [](const auto& a, const auto& b) { return a.second.lastUse < b.second.lastUse; });
+        bytes_ -= oldest->second.samples->size() * sizeof(float);
+        segments_.erase(oldest);
+    }
+}
+
+void SegmentCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    segments_.clear();
+    bytes_ = 0;
+}
+
+size_t SegmentCache::getBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+SeekRenderer::SeekRenderer(const RenderSettings& settings, std::shared_ptr<SegmentCache> cache, uint64_t cacheKey)
+    : settings_(settings)
+    , cache_(std::move(cache))
+    // Segment boundaries and content depend on the block layout too
+    , cacheKey_(hashValue(hashValue(cacheKey, settings.blockFrames), settings.marginFrames))
+{
+}
+
+int SeekRenderer::frameAt(const RenderPlan& plan, double fraction) {
+    const double clamped = std::min(1.0, std::max(0.0, fraction));
+    const int frame = static_cast<int>(clamped * plan.numFrames);
+    return std::max(0, std::min(plan.numFrames - 1, frame));
+}
+
+size_t SeekRenderer::outputSampleAt(const RenderPlan& plan, int frame) {
+    // The render rate divides the output rate, so frames start on output samples
+    const size_t hopOut = static_cast<size_t>(plan.params.hopSize)
+                          * (plan.outputRate / std::max(1, plan.params.sampleRate));
+    return std::min(plan.outputSamples, static_cast<size_t>(std::max(0, frame)) * hopOut);
+}
+
+bool SeekRenderer::render(
+    const GrayscalePlane& image,
+    int startFrame,
+    const BlockCallback& blockCallback,
+    ProgressCallback progressCallback,
+    const std::atomic<bool>* cancelFlag,
+    std::string* errorMessage
+) {
+    auto fail = [errorMessage](const std::string& message) {
+        std::cerr << "SeekRenderer: " << message << std::endl;
+        if (errorMessage) {
+            *errorMessage = message;
+        }
+        return false;
+    };
+    auto cancelled = [cancelFlag]() { return cancelFlag && cancelFlag->load(std::memory_order_relaxed); };
+
+    if (image.isEmpty()) {
+        return fail("No image data");
+    }
+
+    const RenderPlan plan = planRender(settings_, image.getWidth());
+    const int numFrames = plan.numFrames;
+    const int fftSize = plan.params.fftSize;
+    const int hopSize = plan.params.hopSize;
+    if (numFrames <= 0 || fftSize <= 0 || hopSize <= 0) {
+        return fail("Invalid render parameters");
+    }
+
+    const int segmentFrames = std::max(1, settings_.blockFrames);
+    const int numSegments = (numFrames + segmentFrames - 1) / segmentFrames;
+    const int fadeFrames = (fftSize + hopSize - 1) / hopSize;
+    const size_t fade = outputSampleAt(plan, fadeFrames);
+    auto segmentBegin = [&](int i) { return outputSampleAt(plan, i * segmentFrames); };
+    auto segmentEnd = [&](int i) { return (i + 1 >= numSegments) ? plan.outputSamples : segmentBegin(i + 1); };
+    auto tailLength = [&](int i) { return std::min(fade, plan.outputSamples - segmentEnd(i)); };
+
+    startFrame = std::max(0, std::min(numFrames - 1, startFrame));
+    auto report = [&](int frame) {
+        if (progressCallback) {
+            progressCallback(frame - startFrame, numFrames - startFrame);
+        }
+    };
+
+    // Continuation of the previous source past the seam; crossfaded with
+    // the first samples of the next one
+    std::vector<float> tail;
+    size_t tailUsed = 0;
+    std::vector<float> mixed;
+    auto emit = [&](const float* samples, size_t count) {
+        if (count == 0) {
+            return true;
+        }
+        if (tailUsed >= tail.size()) {
+            return blockCallback(samples, count);
+        }
+        const size_t n = std::min(count, tail.size() - tailUsed);
+        mixed.assign(samples, samples + count);
+        for (size_t i = 0; i < n; ++i) {
+            const size_t k = tailUsed + i;
+            const float w = 0.5f - 0.5f * std::cos(static_cast<float>(M_PI) * (k + 0.5f) / tail.size());
+            mixed[i] = tail[k] * (1.0f - w) + mixed[i] * w;
+        }
+        tailUsed += n;
+        return blockCallback(mixed.data(), count);
+    };
+
+    int cachedSegments = 0;
+    int renderedFrames = 0;
+    for (int frame = startFrame; frame < numFrames;) {
+        if (cancelled()) {
+            return fail("Cancelled");
+        }
+
+        const int segment = frame / segmentFrames;
+        std::shared_ptr<const SegmentCache::Samples> cached;
+        if (cache_ && frame == segment * segmentFrames) {
+            cached = cache_->find(cacheKey_, segment);
+        }
+        const size_t length = segmentEnd(segment) - segmentBegin(segment);
+        if (cached && cached->size() >= length) {
+            if (!emit(cached->data(), length)) {
+                return fail("Block output failed");
+            }
+            tail.assign(cached->begin() + length, cached->end());
+            tailUsed = 0;
+            frame = std::min(numFrames, (segment + 1) * segmentFrames);
+            ++cachedSegments;
+            report(frame);
+            continue;
+        }
+
+        // Render up to the next cached segment. The frames past it supply
+        // the crossfade into that segment, and keep the resampler's end
+        // padding out of the samples used.
+        int next = segment + 1;
+        if (!cache_) {
+            next = numSegments;
+        }
+        while (next < numSegments && !cache_->find(cacheKey_, next)) {
+            ++next;
+        }
+        const int runEnd = std::min(numFrames, next * segmentFrames);
+        RenderSettings runSettings = settings_;
+        runSettings.startFrame = frame;
+        runSettings.endFrame = std::min(numFrames, runEnd + 2 * fadeFrames);
+
+        const size_t seam = (runEnd < numFrames) ? segmentBegin(next) : plan.outputSamples;
+        const size_t overlapEnd = std::min(plan.outputSamples, seam + fade);
+        size_t position = outputSampleAt(plan, frame);
+        std::vector<float> nextTail;
+
+        // Complete segments are collected from their first sample
+        int storeSegment = (frame == segment * segmentFrames) ? segment : segment + 1;
+        std::vector<float> pending;
+
+        auto collect = [&](const float* samples, size_t count) {
+            const size_t begin = position;
+            position += count;
+            if (begin < seam && !emit(samples, std::min(count, seam - begin))) {
+                return false;
+            }
+            if (position > seam && begin < overlapEnd) {
+                const size_t from = std::max(begin, seam);
+                const size_t to = std::min(position, overlapEnd);
+                nextTail.insert(nextTail.end(), samples + (from - begin), samples + (to - begin));
+            }
+
+            if (!cache_ || storeSegment >= next) {
+                return true;
+            }
+            const size_t from = std::max(begin, segmentBegin(storeSegment));
+            const size_t to = std::min(position, overlapEnd);
+            if (from < to) {
+                pending.insert(pending.end(), samples + (from - begin), samples + (to - begin));
+            }
+            while (storeSegment < next) {
+                const size_t segmentLength = segmentEnd(storeSegment) - segmentBegin(storeSegment);
+                const size_t storedLength = segmentLength + tailLength(storeSegment);
+                if (pending.size() < storedLength) {
+                    break;
+                }
+                cache_->store(cacheKey_, storeSegment,
+                              std::make_shared<SegmentCache::Samples>(pending.begin(), pending.begin() + storedLength));
+                pending.erase(pending.begin(), pending.begin() + segmentLength);
+                ++storeSegment;
+            }
+            return true;
+        };
+        auto runProgress = [&](int current, int) { report(std::min(runEnd, frame + current)); };
+
+        StreamingRenderer renderer(runSettings);
+        if (!renderer.renderBlocks(image, collect, runProgress, cancelFlag, errorMessage)) {
+            return false;
+        }
+        tail = std::move(nextTail);
+        tailUsed = 0;
+        renderedFrames += runEnd - frame;
+        frame = runEnd;
+        report(frame);
+    }
+
+    std::cout << "SeekRenderer: from frame " << startFrame << " / " << numFrames << ", "
+              << renderedFrames << " frames rendered, " << cachedSegments << " cached segments reused"
+              << std::endl;
+    return true;
+}
+
+} // namespace img2spec
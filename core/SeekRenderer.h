@@ -0,0 +1,96 @@
+#pragma once
+
+#include "core/GrayscalePlane.h"
+#include "core/RenderPipeline.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace img2spec {
+
+/**
+ * Output-rate audio of already played stretches of a preview, so seeking
+ * back to them does not run Griffin-Lim again.
+ *
+ * Segment i holds the blockFrames frames starting at frame i * blockFrames,
+ * followed by a short tail that overlaps the next segment (used to
+ * crossfade into whatever plays after it). Segments belong to one image
+ * and render settings: storing under a new key drops the others. Least
+ * recently used segments are evicted beyond maxBytes. Thread-safe.
+ */
+class SegmentCache {
+public:
+    using Samples = std::vector<float>;
+
+    explicit SegmentCache(size_t maxBytes);
+
+    std::shared_ptr<const Samples> find(uint64_t key, int index);
+    void store(uint64_t key, int index, std::shared_ptr<const Samples> samples);
+    void clear();
+
+    size_t getBytes() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<const Samples> samples;
+        uint64_t lastUse = 0;
+    };
+
+    const size_t maxBytes_;
+    mutable std::mutex mutex_;
+    uint64_t key_ = 0;
+    std::map<int, Entry> segments_;
+    size_t bytes_ = 0;
+    uint64_t useCounter_ = 0;
+};
+
+/**
+ * Seek playback: renders from an arbitrary frame to the end, reusing cached
+ * segments on the way.
+ *
+ * - Uncached stretches are rendered with StreamingRenderer::renderBlocks()
+ *   from the seek frame (or the end of the last cached segment) up to the
+ *   next cached segment, so the first audio is ready after one block
+ *   regardless of the position
+ * - Every complete segment rendered is stored; the partial one at the seek
+ *   position is not
+ * - Independently rendered stretches do not share a phase, so each seam is
+ *   crossfaded over about one FFT frame
+ *
+ * Output is mono at the output rate and not post-processed, like
+ * renderBlocks().
+ */
+class SeekRenderer {
+public:
+    // cacheKey identifies the image and everything upstream of resampling
+    // (RenderCache::Keys::audio); cache may be null
+    SeekRenderer(const RenderSettings& settings, std::shared_ptr<SegmentCache> cache, uint64_t cacheKey);
+
+    // Frame at fraction [0, 1) of the duration, and its first output sample
+    static int frameAt(const RenderPlan& plan, double fraction);
+    static size_t outputSampleAt(const RenderPlan& plan, int frame);
+
+    // Hand the output from startFrame's first sample to the end to
+    // blockCallback. progressCallback receives (frames done, frames from
+    // startFrame to the end).
+    bool render(
+        const GrayscalePlane& image,
+        int startFrame,
+        const BlockCallback& blockCallback,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool>* cancelFlag = nullptr,
+        std::string* errorMessage = nullptr
+    );
+
+private:
+    const RenderSettings settings_;
+    const std::shared_ptr<SegmentCache> cache_;
+    const uint64_t cacheKey_;
+};
+
+} // namespace img2spec
@@ -5,6 +5,32 @@
 
 namespace img2spec {
 
+namespace {
+
+// Blend two image rows for one bin and map to magnitudes, frames [t0, t1)
+template <typename T, typename MapFn>
+void blendBinRow(
+    const T* row0,
+    const T* row1,
+    float frac,
+    float scale,
+    int t0,
+    int t1,
+    int outT0,
+    int outStride,
+    float* out,
+    MapFn mapToMagnitude
+) {
+    const float w0 = (1.0f - frac) * scale;
+    const float w1 = frac * scale;
+    for (int t = t0; t < t1; ++t) {
+        const float pixel = row0[t] * w0 + row1[t] * w1;
+        out[static_cast<size_t>(t - outT0) * outStride] = mapToMagnitude(pixel);
+    }
+}
+
+} // namespace
+
 SpectrogramBuilder::SpectrogramBuilder() {}
 SpectrogramBuilder::~SpectrogramBuilder() {}
 
@@ -21,99 +47,145 @@ float SpectrogramBuilder::mapPixelToMagnitude(float pixel, double minDb, double
     return mag;
 }
 
-std::vector<float> SpectrogramBuilder::resampleColumn(
-    const std::vector<float>& imageData,
-    int imageWidth,
-    int imageHeight,
-    int frameIndex,
-    int numBins,
-    FrequencyScale scale,
-    double minFreqHz,
-    double maxFreqHz,
-    int sampleRate
-) {
-    std::vector<float> column(numBins);
-
-    if (frameIndex >= imageWidth) {
-        std::fill(column.begin(), column.end(), 0.0f);
-        return column;
+bool SpectrogramBuilder::planMatches(int imageHeight, const SpectrogramParams& params) const {
+    if (plan_.empty() || planImageHeight_ != imageHeight) {
+        return false;
+    }
+    if (planParams_.fftSize != params.fftSize || planParams_.freqScale != params.freqScale) {
+        return false;
     }
+    if (params.freqScale == FrequencyScale::Linear) {
+        return true;
+    }
+    return planParams_.minFreqHz == params.minFreqHz
+        && planParams_.maxFreqHz == params.maxFreqHz
+        && planParams_.sampleRate == params.sampleRate;
+}
+
+void SpectrogramBuilder::buildMappingPlan(int imageHeight, const SpectrogramParams& params) {
+    const int numBins = params.fftSize / 2 + 1;
+    plan_.resize(numBins);
+    planImageHeight_ = imageHeight;
+    planParams_ = params;
 
     // Image Y axis maps to frequency bins
     // Note: Image convention is Y=0 at top, but we want high frequencies at top
     // So we flip: imageY=0 → high freq, imageY=(height-1) → low freq (DC)
-
-    if (scale == FrequencyScale::Linear) {
+    auto tapForImageY = [imageHeight](float imageY) {
+        const int y0 = static_cast<int>(std::floor(imageY));
+        const int y1 = std::min(y0 + 1, imageHeight - 1);
+        return BinTap{y0, y1, imageY - y0};
+    };
+    const BinTap bottomRow{imageHeight - 1, imageHeight - 1, 0.0f};
+    const BinTap topRow{0, 0, 0.0f};
+
+    if (params.freqScale == FrequencyScale::Linear) {
         // Linear frequency mapping
         for (int k = 0; k < numBins; ++k) {
             // Map bin k to image Y coordinate linearly
             // k=0 (DC) → bottom of image (imageY = height-1)
             // k=numBins-1 (Nyquist) → top of image (imageY = 0)
             const float imageY = (imageHeight - 1) * (1.0f - static_cast<float>(k) / (numBins - 1));
+            plan_[k] = tapForImageY(imageY);
+        }
+        return;
+    }
+
+    // Logarithmic frequency mapping
+    // Use perceptual scale: more resolution in low frequencies
+    // Map image Y to log frequency, then to bin index
+    const float minFreq = static_cast<float>(params.minFreqHz);
+    const float maxFreq = static_cast<float>(params.maxFreqHz);
+    const float nyquist = params.sampleRate / 2.0f;
+
+    // DC bin: always map to bottom of image
+    plan_[0] = bottomRow;
+
+    for (int k = 1; k < numBins; ++k) {
+        // Frequency of bin k (linear)
+        const float binFreq = static_cast<float>(k) / (numBins - 1) * nyquist;
+
+        // Clamp to specified frequency range
+        if (binFreq < minFreq) {
+            // Below range: use bottom of image
+            plan_[k] = bottomRow;
+        } else if (binFreq > maxFreq) {
+            // Above range: use top of image
+            plan_[k] = topRow;
+        } else {
+            // Map frequency to log scale [0, 1]
+            const float logFreq = std::log(binFreq / minFreq) / std::log(maxFreq / minFreq);
+            const float logFreqClamped = std::max(0.0f, std::min(1.0f, logFreq));
+
+            // Map to image Y coordinate (0 = top = high freq, 1 = bottom = low freq)
+            plan_[k] = tapForImageY((imageHeight - 1) * (1.0f - logFreqClamped));
+        }
+    }
+}
 
-            // Bilinear interpolation
-            const int y0 = static_cast<int>(std::floor(imageY));
-            const int y1 = std::min(y0 + 1, imageHeight - 1);
-            const float fy = imageY - y0;
+void SpectrogramBuilder::prepare(const GrayscalePlane& image, const SpectrogramParams& params) {
+    if (!planMatches(image.getHeight(), params)) {
+        buildMappingPlan(image.getHeight(), params);
+    }
 
-            const float v0 = imageData[y0 * imageWidth + frameIndex];
-            const float v1 = imageData[y1 * imageWidth + frameIndex];
+    image_ = image;
+    numBins_ = params.fftSize / 2 + 1;
+    minDb_ = params.minDb;
+    gamma_ = params.gamma;
+}
 
-            column[k] = v0 * (1.0f - fy) + v1 * fy;
-        }
-    } else {
-        // Logarithmic frequency mapping
-        // Use perceptual scale: more resolution in low frequencies
-        // Map image Y to log frequency, then to bin index
+void SpectrogramBuilder::prepare(
+    const std::vector<float>& imageData,
+    int imageWidth,
+    int imageHeight,
+    const SpectrogramParams& params
+) {
+    prepare(GrayscalePlane::wrap(imageData.data(), imageWidth, imageHeight, PixelFormat::Float32), params);
+}
 
-        const float minFreq = static_cast<float>(minFreqHz);
-        const float maxFreq = static_cast<float>(maxFreqHz);
-        const float nyquist = sampleRate / 2.0f;
+void SpectrogramBuilder::buildFrames(int t0, int t1, float* out) const {
+    if (!isPrepared() || t1 <= t0) {
+        return;
+    }
 
-        for (int k = 0; k < numBins; ++k) {
-            if (k == 0) {
-                // DC bin: always map to bottom of image
-                const float imageY = imageHeight - 1;
-                const int y = std::min(static_cast<int>(imageY), imageHeight - 1);
-                column[k] = imageData[y * imageWidth + frameIndex];
-            } else {
-                // Logarithmic mapping for k >= 1
-                // Frequency of bin k (linear)
-                const float binFreq = static_cast<float>(k) / (numBins - 1) * nyquist;
-
-                // Clamp to specified frequency range
-                if (binFreq < minFreq) {
-                    // Below range: use bottom of image
-                    const float imageY = imageHeight - 1;
-                    const int y = std::min(static_cast<int>(imageY), imageHeight - 1);
-                    column[k] = imageData[y * imageWidth + frameIndex];
-                } else if (binFreq > maxFreq) {
-                    // Above range: use top of image
-                    const float imageY = 0;
-                    column[k] = imageData[static_cast<int>(imageY) * imageWidth + frameIndex];
-                } else {
-                    // Map frequency to log scale [0, 1]
-                    const float logFreq = std::log(binFreq / minFreq) / std::log(maxFreq / minFreq);
-                    const float logFreqClamped = std::max(0.0f, std::min(1.0f, logFreq));
-
-                    // Map to image Y coordinate (0 = top = high freq, 1 = bottom = low freq)
-                    const float imageY = (imageHeight - 1) * (1.0f - logFreqClamped);
-
-                    // Bilinear interpolation
-                    const int y0 = static_cast<int>(std::floor(imageY));
-                    const int y1 = std::min(y0 + 1, imageHeight - 1);
-                    const float fy = imageY - y0;
-
-                    const float v0 = imageData[y0 * imageWidth + frameIndex];
-                    const float v1 = imageData[y1 * imageWidth + frameIndex];
-
-                    column[k] = v0 * (1.0f - fy) + v1 * fy;
-                }
-            }
+    const float silence = mapPixelToMagnitude(0.0f, minDb_, gamma_);
+
+    // Frames inside the image: walk each bin's rows left to right so image
+    // reads stay contiguous, scattering into the frame-major output.
+    const int inStart = std::min(std::max(t0, 0), t1);
+    const int inEnd = std::max(std::min(t1, image_.getWidth()), inStart);
+    const float scale = GrayscalePlane::normalizationScale(image_.getFormat());
+    const double minDb = minDb_;
+    const double gamma = gamma_;
+    auto toMagnitude = [minDb, gamma](float pixel) {
+        return mapPixelToMagnitude(pixel, minDb, gamma);
+    };
+
+    for (int k = 0; k < numBins_; ++k) {
+        const BinTap& tap = plan_[k];
+        float* dst = out + k;
+
+        for (int t = t0; t < inStart; ++t) {
+            dst[static_cast<size_t>(t - t0) * numBins_] = silence;
+        }
+        switch (image_.getFormat()) {
+            case PixelFormat::UInt8:
+                blendBinRow(image_.row<uint8_t>(tap.row0), image_.row<uint8_t>(tap.row1), tap.frac, scale,
+                            inStart, inEnd, t0, numBins_, dst, toMagnitude);
+                break;
+            case PixelFormat::UInt16:
+                blendBinRow(image_.row<uint16_t>(tap.row0), image_.row<uint16_t>(tap.row1), tap.frac, scale,
+                            inStart, inEnd, t0, numBins_, dst, toMagnitude);
+                break;
+            case PixelFormat::Float32:
+                blendBinRow(image_.row<float>(tap.row0), image_.row<float>(tap.row1), tap.frac, scale,
+                            inStart, inEnd, t0, numBins_, dst, toMagnitude);
+                break;
+        }
+        for (int t = inEnd; t < t1; ++t) {
+            dst[static_cast<size_t>(t - t0) * numBins_] = silence;
         }
     }
-
-    return column;
 }
 
 std::vector<std::vector<float>> SpectrogramBuilder::buildMagnitudeSpectrogram(
@@ -122,6 +194,16 @@ std::vector<std::vector<float>> SpectrogramBuilder::buildMagnitudeSpectrogram(
     int imageHeight,
     const SpectrogramParams& params
 ) {
+    return buildMagnitudeSpectrogram(
+        GrayscalePlane::wrap(imageData.data(), imageWidth, imageHeight, PixelFormat::Float32), params);
+}
+
+std::vector<std::vector<float>> SpectrogramBuilder::buildMagnitudeSpectrogram(
+    const GrayscalePlane& image,
+    const SpectrogramParams& params
+) {
+    const int imageWidth = image.getWidth();
+    const int imageHeight = image.getHeight();
     const int numBins = params.fftSize / 2 + 1;
     const int numFrames = imageWidth;
 
@@ -131,19 +213,19 @@ std::vector<std::vector<float>> SpectrogramBuilder::buildMagnitudeSpectrogram(
     std::cout << "  Frequency scale: " << (params.freqScale == FrequencyScale::Linear ? "Linear" : "Logarithmic") << std::endl;
     std::cout << "  Min dB: " << params.minDb << ", Gamma: " << params.gamma << std::endl;
 
-    std::vector<std::vector<float>> spectrogram(numFrames);
+    prepare(image, params);
 
-    for (int t = 0; t < numFrames; ++t) {
-        // Get column from image (resample to numBins)
-        std::vector<float> pixelColumn = resampleColumn(
-            imageData, imageWidth, imageHeight, t, numBins, params.freqScale,
-            params.minFreqHz, params.maxFreqHz, params.sampleRate
-        );
+    // Generate in blocks so each image row is read contiguously
+    constexpr int kBlockFrames = 64;
+    std::vector<float> block(static_cast<size_t>(kBlockFrames) * numBins);
+    std::vector<std::vector<float>> spectrogram(numFrames);
 
-        // Convert pixels to magnitudes
-        spectrogram[t].resize(numBins);
-        for (int k = 0; k < numBins; ++k) {
-            spectrogram[t][k] = mapPixelToMagnitude(pixelColumn[k], params.minDb, params.gamma);
+    for (int t0 = 0; t0 < numFrames; t0 += kBlockFrames) {
+        const int t1 = std::min(t0 + kBlockFrames, numFrames);
+        buildFrames(t0, t1, block.data());
+        for (int t = t0; t < t1; ++t) {
+            const float* frame = block.data() + static_cast<size_t>(t - t0) * numBins;
+            spectrogram[t].assign(frame, frame + numBins);
         }
     }
 
@@ -3,6 +3,8 @@
 #include <vector>
 #include <string>
 
+#include "core/GrayscalePlane.h"
+
 namespace img2spec {
 
 enum class FrequencyScale {
@@ -35,19 +37,55 @@ public:
         const SpectrogramParams& params
     );
 
-private:
-    float mapPixelToMagnitude(float pixel, double minDb, double gamma);
-    std::vector<float> resampleColumn(
+    // Build magnitude spectrogram from a compact grayscale plane
+    std::vector<std::vector<float>> buildMagnitudeSpectrogram(
+        const GrayscalePlane& image,
+        const SpectrogramParams& params
+    );
+
+    // Prepare the builder for pull-style frame generation.
+    // The bin -> image row mapping plan is cached and only rebuilt when the
+    // image height or frequency mapping parameters change.
+    // Pixels are converted to float inside the frame kernels; the plane
+    // shares its pixels, so prepare() never copies the image.
+    void prepare(const GrayscalePlane& image, const SpectrogramParams& params);
+
+    // imageData is not copied and must outlive subsequent buildFrames() calls.
+    void prepare(
         const std::vector<float>& imageData,
         int imageWidth,
         int imageHeight,
-        int frameIndex,
-        int numBins,
-        FrequencyScale scale,
-        double minFreqHz,
-        double maxFreqHz,
-        int sampleRate
+        const SpectrogramParams& params
     );
+
+    bool isPrepared() const { return !image_.isEmpty(); }
+    int getNumFrames() const { return image_.getWidth(); }
+    int getNumBins() const { return numBins_; }
+
+    // Write magnitude frames [t0, t1) into out (frame-major, (t1 - t0) x numBins).
+    // Frames outside the image are written as silence (magnitude of pixel 0).
+    void buildFrames(int t0, int t1, float* out) const;
+
+private:
+    // Image rows blended for one frequency bin: value = row0 * (1 - frac) + row1 * frac
+    struct BinTap {
+        int row0;
+        int row1;
+        float frac;
+    };
+
+    static float mapPixelToMagnitude(float pixel, double minDb, double gamma);
+    void buildMappingPlan(int imageHeight, const SpectrogramParams& params);
+    bool planMatches(int imageHeight, const SpectrogramParams& params) const;
+
+    std::vector<BinTap> plan_;
+    SpectrogramParams planParams_;
+    int planImageHeight_ = 0;
+
+    GrayscalePlane image_;
+    int numBins_ = 0;
+    double minDb_ = -80.0;
+    double gamma_ = 1.0;
 };
 
 } // namespace img2spec
@@ -42,6 +42,10 @@ std::vector<std::vector<std::complex<float>>> Stft::forward(const std::vector<fl
     std::vector<kiss_fft_cpx> fftOut(numBins);
 
     for (int t = 0; t < numFrames; ++t) {
+        if (isCancelled()) {
+            break;
+        }
+
         const int startIdx = t * hopSize_;
 
         // Extract and window frame
@@ -62,8 +66,10 @@ std::vector<std::vector<std::complex<float>>> Stft::forward(const std::vector<fl
 
     kiss_fftr_free(fftCfg);
 
-    std::cout << "Stft::forward: Processed " << numFrames << " frames, "
-              << numBins << " bins per frame" << std::endl;
+    if (verbose_) {
+        std::cout << "Stft::forward: Processed " << numFrames << " frames, "
+                  << numBins << " bins per frame" << std::endl;
+    }
 
     return spectrogram;
 }
@@ -93,6 +99,10 @@ std::vector<float> Stft::inverse(const std::vector<std::vector<std::complex<floa
     std::vector<float> frame(fftSize_);
 
     for (int t = 0; t < numFrames; ++t) {
+        if (isCancelled()) {
+            break;
+        }
+
         // Convert to Kiss FFT format
         for (int k = 0; k < numBins; ++k) {
             fftIn[k].r = spectrogram[t][k].real();
@@ -122,8 +132,10 @@ std::vector<float> Stft::inverse(const std::vector<std::vector<std::complex<floa
         }
     }
 
-    std::cout << "Stft::inverse: Reconstructed " << outputLength << " samples from "
-              << numFrames << " frames" << std::endl;
+    if (verbose_) {
+        std::cout << "Stft::inverse: Reconstructed " << outputLength << " samples from "
+                  << numFrames << " frames" << std::endl;
+    }
 
     return output;
 }
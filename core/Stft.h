@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include <complex>
 
@@ -20,12 +21,24 @@ public:
     int getHopSize() const { return hopSize_; }
     int getNumBins() const { return fftSize_ / 2 + 1; }
 
+    // Per-call logging; block-wise renderers call forward/inverse thousands of times
+    void setVerbose(bool verbose) { verbose_ = verbose; }
+
+    // When set and raised, forward/inverse stop at the next frame and return
+    // a partial result; callers check the flag and discard it
+    void setCancelFlag(const std::atomic<bool>* cancelFlag) { cancelFlag_ = cancelFlag; }
+    const std::atomic<bool>* getCancelFlag() const { return cancelFlag_; }
+
 private:
     void createWindow();
 
     int fftSize_;
     int hopSize_;
     std::vector<float> window_;
+    bool isCancelled() const { return cancelFlag_ && cancelFlag_->load(std::memory_order_relaxed); }
+
+    bool verbose_ = true;
+    const std::atomic<bool>* cancelFlag_ = nullptr;
 };
 
 } // namespace img2spec
@@ -1,11 +1,239 @@
 #include "core/WavWriter.h"
+#include "core/MappedFile.h"
+#include "core/Parallel.h"
+#include "core/SpscRing.h"
 #include <sndfile.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <thread>
 
 namespace img2spec {
 
+namespace {
+
+constexpr size_t kBlockFrames = 8192;
+constexpr size_t kQueueBlocks = 32;
+
+// Spin briefly, then sleep: queue waits are short when both sides keep up
+void backoff(int& idle) {
+    if (++idle < 64) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+int subformatFor(BitDepth bitDepth) {
+    switch (bitDepth) {
+        case BitDepth::Int16: return SF_FORMAT_PCM_16;
+        case BitDepth::Int24: return SF_FORMAT_PCM_24;
+        case BitDepth::Float32: return SF_FORMAT_FLOAT;
+    }
+    return SF_FORMAT_PCM_16;
+}
+
+int bytesPerSample(BitDepth bitDepth) {
+    switch (bitDepth) {
+        case BitDepth::Int16: return 2;
+        case BitDepth::Int24: return 3;
+        case BitDepth::Float32: return 4;
+    }
+    return 2;
+}
+
+void logWritten(const std::string& path, size_t numFrames, int channels, int sampleRate, BitDepth bitDepth) {
+    std::cout << "WavWriter: Successfully wrote " << path << std::endl;
+    std::cout << "  Frames: " << numFrames << std::endl;
+    std::cout << "  Channels: " << channels << std::endl;
+    std::cout << "  Sample Rate: " << sampleRate << " Hz" << std::endl;
+    std::cout << "  Bit Depth: ";
+    switch (bitDepth) {
+        case BitDepth::Int16: std::cout << "16-bit PCM"; break;
+        case BitDepth::Int24: std::cout << "24-bit PCM"; break;
+        case BitDepth::Float32: std::cout << "32-bit Float"; break;
+    }
+    std::cout << std::endl;
+}
+
+// Little-endian RIFF field writers
+void put16(std::vector<unsigned char>& out, uint32_t v) {
+    out.push_back(static_cast<unsigned char>(v & 0xFF));
+    out.push_back(static_cast<unsigned char>((v >> 8) & 0xFF));
+}
+
+void put32(std::vector<unsigned char>& out, uint32_t v) {
+    put16(out, v & 0xFFFF);
+    put16(out, v >> 16);
+}
+
+void put64(std::vector<unsigned char>& out, uint64_t v) {
+    put32(out, static_cast<uint32_t>(v & 0xFFFFFFFFull));
+    put32(out, static_cast<uint32_t>(v >> 32));
+}
+
+void putTag(std::vector<unsigned char>& out, const char* tag) {
+    out.insert(out.end(), tag, tag + 4);
+}
+
+// Canonical WAV header: RIFF (or RF64 + ds64 when over 4 GB), fmt
+// (PCM or IEEE float), fact for float, then the data chunk header
+std::vector<unsigned char> buildWavHeader(int channels, int sampleRate, BitDepth bitDepth,
+                                          uint64_t numFrames, uint64_t dataBytes) {
+    const bool isFloat = (bitDepth == BitDepth::Float32);
+    const uint32_t fmtSize = isFloat ? 18 : 16;
+    const uint64_t padded = dataBytes + (dataBytes & 1);
+    const uint64_t riffSize = 4 + (8 + fmtSize) + (isFloat ? 12 : 0) + 8 + padded;
+    const bool rf64 = (riffSize + 36 > 0xFFFFFFFFull); // ds64 adds 36 bytes
+    const int sampleBytes = bytesPerSample(bitDepth);
+
+    std::vector<unsigned char> header;
+    if (rf64) {
+        putTag(header, "RF64");
+        put32(header, 0xFFFFFFFFu);
+        putTag(header, "WAVE");
+        putTag(header, "ds64");
+        put32(header, 28);
+        put64(header, riffSize + 36);
+        put64(header, dataBytes);
+        put64(header, numFrames);
+        put32(header, 0); // no table entries
+    } else {
+        putTag(header, "RIFF");
+        put32(header, static_cast<uint32_t>(riffSize));
+        putTag(header, "WAVE");
+    }
+
+    putTag(header, "fmt ");
+    put32(header, fmtSize);
+    put16(header, isFloat ? 3 : 1); // WAVE_FORMAT_IEEE_FLOAT / WAVE_FORMAT_PCM
+    put16(header, static_cast<uint32_t>(channels));
+    put32(header, static_cast<uint32_t>(sampleRate));
+    put32(header, static_cast<uint32_t>(sampleRate * channels * sampleBytes));
+    put16(header, static_cast<uint32_t>(channels * sampleBytes));
+    put16(header, static_cast<uint32_t>(sampleBytes * 8));
+    if (isFloat) {
+        put16(header, 0); // cbSize
+        putTag(header, "fact");
+        put32(header, 4);
+        put32(header, rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(numFrames));
+    }
+
+    putTag(header, "data");
+    put32(header, rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(dataBytes));
+    return header;
+}
+
+// Serialize samples as little-endian bytes, independent of host order
+void packInt16(const int16_t* in, size_t numSamples, unsigned char* out) {
+    for (size_t i = 0; i < numSamples; ++i) {
+        const uint16_t v = static_cast<uint16_t>(in[i]);
+        out[2 * i + 0] = static_cast<unsigned char>(v & 0xFF);
+        out[2 * i + 1] = static_cast<unsigned char>(v >> 8);
+    }
+}
+
+void packInt24(const int32_t* in, size_t numSamples, unsigned char* out) {
+    // Input is left-justified (value << 8): emit the top three bytes
+    for (size_t i = 0; i < numSamples; ++i) {
+        const uint32_t v = static_cast<uint32_t>(in[i]);
+        out[3 * i + 0] = static_cast<unsigned char>((v >> 8) & 0xFF);
+        out[3 * i + 1] = static_cast<unsigned char>((v >> 16) & 0xFF);
+        out[3 * i + 2] = static_cast<unsigned char>(v >> 24);
+    }
+}
+
+void packFloat(const float* in, size_t numSamples, unsigned char* out) {
+    for (size_t i = 0; i < numSamples; ++i) {
+        uint32_t v;
+        std::memcpy(&v, &in[i], sizeof(v));
+        out[4 * i + 0] = static_cast<unsigned char>(v & 0xFF);
+        out[4 * i + 1] = static_cast<unsigned char>((v >> 8) & 0xFF);
+        out[4 * i + 2] = static_cast<unsigned char>((v >> 16) & 0xFF);
+        out[4 * i + 3] = static_cast<unsigned char>(v >> 24);
+    }
+}
+
+} // namespace
+
+struct WavWriter::Handle {
+    SNDFILE* file = nullptr;
+    int channels = 1;
+    BitDepth bitDepth = BitDepth::Int16;
+    std::unique_ptr<Quantizer> quantizer;
+    std::vector<int16_t> pcm16;
+    std::vector<int32_t> pcm32;
+
+    // Background writer: filled blocks go out through queue, emptied
+    // buffers come back through recycle so steady state allocates nothing
+    std::thread thread;
+    SpscRing<std::vector<float>> queue{kQueueBlocks};
+    SpscRing<std::vector<float>> recycle{kQueueBlocks};
+    std::atomic<bool> closing{false};
+    std::atomic<bool> failed{false};
+
+    // Quantize (for integer formats) and hand one interleaved block to libsndfile
+    bool writeBlock(const float* data, size_t numFrames) {
+        const size_t numSamples = numFrames * channels;
+        const sf_count_t frames = static_cast<sf_count_t>(numFrames);
+        sf_count_t written = 0;
+        switch (bitDepth) {
+            case BitDepth::Int16:
+                pcm16.resize(numSamples);
+                quantizer->quantize(data, numSamples, pcm16.data());
+                written = sf_writef_short(file, pcm16.data(), frames);
+                break;
+            case BitDepth::Int24:
+                pcm32.resize(numSamples);
+                quantizer->quantize(data, numSamples, pcm32.data());
+                written = sf_writef_int(file, pcm32.data(), frames);
+                break;
+            case BitDepth::Float32:
+                written = sf_writef_float(file, data, frames);
+                break;
+        }
+        if (written != frames) {
+            std::cerr << "WavWriter: Write error. Expected " << numFrames
+                      << " frames, wrote " << written << std::endl;
+            std::cerr << "  libsndfile error: " << sf_strerror(file) << std::endl;
+            failed.store(true, std::memory_order_release);
+            return false;
+        }
+        return true;
+    }
+
+    void run() {
+        std::vector<float> block;
+        int idle = 0;
+        while (true) {
+            if (queue.tryPop(block)) {
+                if (!failed.load(std::memory_order_acquire)) {
+                    writeBlock(block.data(), block.size() / channels);
+                }
+                recycle.tryPush(std::move(block));
+                idle = 0;
+            } else if (closing.load(std::memory_order_acquire)) {
+                // All pushes happen before closing is set
+                if (queue.empty()) {
+                    break;
+                }
+            } else {
+                backoff(idle);
+            }
+        }
+    }
+};
+
 WavWriter::WavWriter() {}
-WavWriter::~WavWriter() {}
+
+WavWriter::~WavWriter() {
+    if (handle_) {
+        finalize();
+    }
+}
 
 bool WavWriter::write(
     const std::string& path,
@@ -14,68 +242,273 @@ bool WavWriter::write(
     int sampleRate,
     BitDepth bitDepth
 ) {
-    return writeWithLibsndfile(path, audio, channels, sampleRate, bitDepth);
+    const size_t numFrames = (channels > 0) ? audio.size() / channels : 0;
+    return write(path, AudioView::interleaved(audio.data(), numFrames, channels), sampleRate, bitDepth);
 }
 
-bool WavWriter::writeWithLibsndfile(
+bool WavWriter::write(
     const std::string& path,
-    const std::vector<float>& audio,
-    int channels,
+    const AudioView& audio,
     int sampleRate,
     BitDepth bitDepth
 ) {
-    SF_INFO sfInfo;
+    if (backend_ == WavBackend::MemoryMapped) {
+        if (writeMapped(path, audio, sampleRate, bitDepth)) {
+            return true;
+        }
+        std::cerr << "WavWriter: Memory-mapped write failed, falling back to libsndfile" << std::endl;
+    }
+
+    if (!open(path, audio.getNumChannels(), sampleRate, bitDepth, audio.getNumFrames())) {
+        return false;
+    }
+    const bool appended = append(audio);
+    const bool finalized = finalize();
+    return appended && finalized;
+}
+
+bool WavWriter::open(
+    const std::string& path,
+    int channels,
+    int sampleRate,
+    BitDepth bitDepth,
+    size_t expectedFrames
+) {
+    if (handle_) {
+        finalize();
+    }
+
+    SF_INFO sfInfo = {};
     sfInfo.samplerate = sampleRate;
     sfInfo.channels = channels;
-    sfInfo.format = SF_FORMAT_WAV;
 
-    // Set subformat based on bit depth
-    switch (bitDepth) {
-        case BitDepth::Int16:
-            sfInfo.format |= SF_FORMAT_PCM_16;
-            break;
-        case BitDepth::Int24:
-            sfInfo.format |= SF_FORMAT_PCM_24;
-            break;
-        case BitDepth::Float32:
-            sfInfo.format |= SF_FORMAT_FLOAT;
-            break;
+    // RF64 lifts the 4 GB RIFF limit; auto-downgrade rewrites the header
+    // as plain WAV on close when the data turned out small enough
+    sfInfo.format = SF_FORMAT_RF64 | subformatFor(bitDepth);
+    SNDFILE* file = sf_open(path.c_str(), SFM_WRITE, &sfInfo);
+    if (file) {
+        sf_command(file, SFC_RF64_AUTO_DOWNGRADE, nullptr, SF_TRUE);
+    } else {
+        // libsndfile without RF64: W64 for large outputs, WAV otherwise
+        const uint64_t expectedBytes = static_cast<uint64_t>(expectedFrames) * channels * bytesPerSample(bitDepth);
+        const bool large = expectedBytes >= 0xFFFFFFFFull - 1024;
+        sfInfo = {};
+        sfInfo.samplerate = sampleRate;
+        sfInfo.channels = channels;
+        sfInfo.format = (large ? SF_FORMAT_W64 : SF_FORMAT_WAV) | subformatFor(bitDepth);
+        file = sf_open(path.c_str(), SFM_WRITE, &sfInfo);
     }
 
-    // Open file for writing
-    SNDFILE* file = sf_open(path.c_str(), SFM_WRITE, &sfInfo);
     if (!file) {
         std::cerr << "WavWriter: Failed to open file: " << path << std::endl;
         std::cerr << "  libsndfile error: " << sf_strerror(nullptr) << std::endl;
         return false;
     }
 
-    // Write audio data
-    const sf_count_t numFrames = audio.size() / channels;
-    const sf_count_t written = sf_writef_float(file, audio.data(), numFrames);
+    handle_ = std::make_unique<Handle>();
+    handle_->file = file;
+    handle_->channels = channels;
+    handle_->bitDepth = bitDepth;
+    if (bitDepth != BitDepth::Float32) {
+        handle_->quantizer = std::make_unique<Quantizer>(bitDepth == BitDepth::Int16 ? 16 : 24, channels, dither_);
+    }
+    if (async_) {
+        Handle* handle = handle_.get();
+        handle_->thread = std::thread([handle]() { handle->run(); });
+    }
+    path_ = path;
+    channels_ = channels;
+    sampleRate_ = sampleRate;
+    bitDepth_ = bitDepth;
+    framesWritten_ = 0;
+    failed_ = false;
+    return true;
+}
 
-    if (written != numFrames) {
-        std::cerr << "WavWriter: Write error. Expected " << numFrames
-                  << " frames, wrote " << written << std::endl;
-        sf_close(file);
+bool WavWriter::append(const float* interleaved, size_t numFrames) {
+    if (!handle_ || failed_) {
         return false;
     }
 
-    // Close file
-    sf_close(file);
+    if (!handle_->thread.joinable()) {
+        if (!handle_->writeBlock(interleaved, numFrames)) {
+            failed_ = true;
+            return false;
+        }
+        framesWritten_ += numFrames;
+        return true;
+    }
 
-    std::cout << "WavWriter: Successfully wrote " << path << std::endl;
-    std::cout << "  Frames: " << numFrames << std::endl;
-    std::cout << "  Channels: " << channels << std::endl;
-    std::cout << "  Sample Rate: " << sampleRate << " Hz" << std::endl;
-    std::cout << "  Bit Depth: ";
-    switch (bitDepth) {
-        case BitDepth::Int16: std::cout << "16-bit PCM"; break;
-        case BitDepth::Int24: std::cout << "24-bit PCM"; break;
-        case BitDepth::Float32: std::cout << "32-bit Float"; break;
+    for (size_t frame = 0; frame < numFrames; frame += kBlockFrames) {
+        const size_t count = std::min(kBlockFrames, numFrames - frame);
+        std::vector<float> block = acquireBlock();
+        block.resize(count * channels_);
+        std::memcpy(block.data(), interleaved + frame * channels_, block.size() * sizeof(float));
+        if (!submit(std::move(block), count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WavWriter::append(const AudioView& audio) {
+    if (!handle_ || failed_) {
+        return false;
+    }
+    if (audio.getNumChannels() != channels_) {
+        std::cerr << "WavWriter: Channel count mismatch (" << audio.getNumChannels()
+                  << " vs " << channels_ << ")" << std::endl;
+        return false;
+    }
+
+    // Interleave one block at a time, straight into the queued buffer when async
+    const bool async = handle_->thread.joinable();
+    for (size_t frame = 0; frame < audio.getNumFrames(); frame += kBlockFrames) {
+        const size_t count = std::min(kBlockFrames, audio.getNumFrames() - frame);
+        if (async) {
+            std::vector<float> block = acquireBlock();
+            block.resize(count * channels_);
+            audio.interleave(frame, count, block.data());
+            if (!submit(std::move(block), count)) {
+                return false;
+            }
+        } else {
+            block_.resize(kBlockFrames * channels_);
+            audio.interleave(frame, count, block_.data());
+            if (!append(block_.data(), count)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<float> WavWriter::acquireBlock() {
+    std::vector<float> block;
+    if (!handle_->recycle.tryPop(block)) {
+        block.reserve(kBlockFrames * channels_);
+    }
+    return block;
+}
+
+bool WavWriter::submit(std::vector<float>&& block, size_t numFrames) {
+    int idle = 0;
+    while (!handle_->queue.tryPush(std::move(block))) {
+        if (handle_->failed.load(std::memory_order_acquire)) {
+            break;
+        }
+        backoff(idle);
+    }
+    if (handle_->failed.load(std::memory_order_acquire)) {
+        failed_ = true;
+        return false;
+    }
+    framesWritten_ += numFrames;
+    return true;
+}
+
+bool WavWriter::finalize() {
+    if (!handle_) {
+        return false;
+    }
+
+    if (handle_->thread.joinable()) {
+        handle_->closing.store(true, std::memory_order_release);
+        handle_->thread.join();
+        failed_ = failed_ || handle_->failed.load(std::memory_order_acquire);
+    }
+
+    const int closeResult = sf_close(handle_->file);
+    handle_.reset();
+    block_.clear();
+    block_.shrink_to_fit();
+
+    if (failed_ || closeResult != 0) {
+        std::cerr << "WavWriter: Failed to finalize " << path_ << std::endl;
+        return false;
+    }
+
+    logWritten(path_, framesWritten_, channels_, sampleRate_, bitDepth_);
+    return true;
+}
+
+bool WavWriter::writeMapped(
+    const std::string& path,
+    const AudioView& audio,
+    int sampleRate,
+    BitDepth bitDepth
+) {
+    if (audio.isEmpty()) {
+        return false;
+    }
+
+    const int channels = audio.getNumChannels();
+    const size_t numFrames = audio.getNumFrames();
+    const size_t sampleBytes = static_cast<size_t>(bytesPerSample(bitDepth));
+    const size_t frameBytes = sampleBytes * channels;
+    const uint64_t dataBytes = static_cast<uint64_t>(numFrames) * frameBytes;
+    const std::vector<unsigned char> header = buildWavHeader(channels, sampleRate, bitDepth, numFrames, dataBytes);
+    const uint64_t fileSize = header.size() + dataBytes + (dataBytes & 1);
+    if (fileSize > static_cast<uint64_t>(SIZE_MAX)) {
+        return false;
+    }
+
+    MappedFile mapping;
+    if (!mapping.createReadWrite(path, static_cast<size_t>(fileSize))) {
+        return false;
+    }
+    unsigned char* dst = mapping.mutableData();
+    std::memcpy(dst, header.data(), header.size());
+    unsigned char* payload = dst + header.size();
+    if (dataBytes & 1) {
+        payload[dataBytes] = 0; // RIFF pad byte
+    }
+
+    const int bits = (bitDepth == BitDepth::Int16) ? 16 : 24;
+    auto convertBlocks = [&](size_t block0, size_t block1, Quantizer* quantizer) {
+        std::vector<float> samples(kBlockFrames * channels);
+        std::vector<int16_t> pcm16;
+        std::vector<int32_t> pcm32;
+        for (size_t block = block0; block < block1; ++block) {
+            const size_t frame = block * kBlockFrames;
+            const size_t count = std::min(kBlockFrames, numFrames - frame);
+            const size_t numSamples = count * channels;
+            unsigned char* out = payload + frame * frameBytes;
+            audio.interleave(frame, count, samples.data());
+            switch (bitDepth) {
+                case BitDepth::Int16:
+                    pcm16.resize(numSamples);
+                    quantizer->quantize(samples.data(), numSamples, pcm16.data());
+                    packInt16(pcm16.data(), numSamples, out);
+                    break;
+                case BitDepth::Int24:
+                    pcm32.resize(numSamples);
+                    quantizer->quantize(samples.data(), numSamples, pcm32.data());
+                    packInt24(pcm32.data(), numSamples, out);
+                    break;
+                case BitDepth::Float32:
+                    packFloat(samples.data(), numSamples, out);
+                    break;
+            }
+        }
+    };
+
+    const size_t numBlocks = (numFrames + kBlockFrames - 1) / kBlockFrames;
+    const bool dithered = (bitDepth != BitDepth::Float32) && (dither_.tpdf || dither_.noiseShaping);
+    if (dithered) {
+        // Dither state runs across the whole file: convert in order
+        Quantizer quantizer(bits, channels, dither_);
+        convertBlocks(0, numBlocks, &quantizer);
+    } else {
+        // Undithered quantization is stateless, so blocks are independent
+        parallelFor(0, static_cast<int>(numBlocks), [&](int b0, int b1) {
+            Quantizer quantizer(bits, channels);
+            convertBlocks(static_cast<size_t>(b0), static_cast<size_t>(b1), &quantizer);
+        });
     }
-    std::cout << std::endl;
 
+    mapping.close();
+    logWritten(path, numFrames, channels, sampleRate, bitDepth);
     return true;
 }
 
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "core/ChannelLayout.h"
+#include "core/Quantizer.h"
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -11,11 +15,19 @@ enum class BitDepth {
     Float32
 };
 
+enum class WavBackend {
+    Libsndfile,   // buffered writes through libsndfile
+    MemoryMapped  // preallocated file, own RIFF/RF64 header, parallel conversion into the mapping
+};
+
 class WavWriter {
 public:
     WavWriter();
     ~WavWriter();
 
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
     // Write audio to WAV file
     // audio: interleaved samples (mono: [s0, s1, ...], stereo: [L0, R0, L1, R1, ...])
     // channels: 1 (mono) or 2 (stereo)
@@ -30,14 +42,77 @@ public:
         BitDepth bitDepth
     );
 
-private:
-    bool writeWithLibsndfile(
+    // Write audio from a channel view (e.g. a mono buffer broadcast to
+    // stereo); frames are interleaved block by block while writing
+    bool write(
+        const std::string& path,
+        const AudioView& audio,
+        int sampleRate,
+        BitDepth bitDepth
+    );
+
+    // Streaming API: open() -> append() any number of times -> finalize().
+    // Files are created as RF64 with automatic downgrade, so they end up as
+    // plain WAV unless the data exceeds 4 GB. expectedFrames is only a hint
+    // used to pick W64 when RF64 is unavailable.
+    bool open(
         const std::string& path,
-        const std::vector<float>& audio,
         int channels,
         int sampleRate,
+        BitDepth bitDepth,
+        size_t expectedFrames = 0
+    );
+
+    // Append interleaved frames
+    bool append(const float* interleaved, size_t numFrames);
+
+    // Append frames from a channel view (channel count must match open())
+    bool append(const AudioView& audio);
+
+    // Update the header and close the file (waits for the writer thread)
+    bool finalize();
+
+    // Options below take effect at the next open()
+
+    // Quantize and write on a background thread fed by a lock-free queue,
+    // so append() returns as soon as the block is queued
+    void setAsync(bool async) { async_ = async; }
+
+    // Dither for 16/24-bit output (default off)
+    void setDither(const DitherSettings& dither) { dither_ = dither; }
+
+    // Backend for the one-shot write() calls (the streaming API always uses
+    // libsndfile). MemoryMapped falls back to libsndfile if mapping fails;
+    // both produce identical sample data.
+    void setBackend(WavBackend backend) { backend_ = backend; }
+
+    bool isOpen() const { return handle_ != nullptr; }
+    size_t getFramesWritten() const { return framesWritten_; }
+
+private:
+    struct Handle; // libsndfile handle, quantizer and writer thread state
+
+    bool writeMapped(
+        const std::string& path,
+        const AudioView& audio,
+        int sampleRate,
         BitDepth bitDepth
     );
+
+    bool submit(std::vector<float>&& block, size_t numFrames);
+    std::vector<float> acquireBlock();
+
+    std::unique_ptr<Handle> handle_;
+    std::string path_;
+    int channels_ = 0;
+    int sampleRate_ = 0;
+    BitDepth bitDepth_ = BitDepth::Int16;
+    size_t framesWritten_ = 0;
+    bool failed_ = false;
+    bool async_ = false;
+    WavBackend backend_ = WavBackend::Libsndfile;
+    DitherSettings dither_;
+    std::vector<float> block_;
 };
 
 } // namespace img2spec